@@ -0,0 +1,388 @@
+/**
+ * @file    bench.c
+ * @brief   Micro-benchmarks of the core Brin functions across input sizes.
+ *
+ * Each operation runs on inputs from 8 B up to 64 MB and reports the time
+ * per call, the throughput over the input bytes and the heap allocations
+ * per call. Allocations are counted by wrapping malloc, calloc and realloc
+ * at link time (`-Wl,--wrap=...`, see `make bench`), so only calls made by
+ * this program and libbrin.a are seen.
+ *
+ * Usage: bench [--json] [--max-size BYTES] [--only NAME]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <brin.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MIN_SIZE 8
+#define BENCH_MAX_SIZE ((size_t)64 << 20)
+/* Input bytes processed per measurement; sets the iteration count. */
+#define BENCH_TARGET_BYTES ((size_t)128 << 20)
+#define BENCH_MAX_ITERATIONS 100000
+/* Prepared inputs held at once, bounded both in bytes and in count. */
+#define BENCH_BATCH_BYTES ((size_t)64 << 20)
+#define BENCH_MAX_BATCH 1024
+
+static size_t allocations;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    allocations++;
+    return __real_realloc(ptr, size);
+}
+
+static void *bench_alloc(size_t size)
+{
+    void *p = malloc(size);
+    if (!p)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* Input shared by every operation of one size. */
+struct Input
+{
+    char *text;
+    size_t size;
+    Brin brin;
+    /* Words of `text`, pointing into `word_buffer`, for brin_join(). */
+    const char **words;
+    size_t word_count;
+    char *word_buffer;
+};
+
+/*
+ * Space-separated lowercase and capitalised words, with two spaces at
+ * each end so that trimming has work to do.
+ */
+static void input_init(struct Input *in, size_t size)
+{
+    static const char words[] =
+        "Lorem ipsum dolor sit amet, consectetur adipiscing elit sed do ";
+
+    in->size = size;
+    in->text = bench_alloc(size + 1);
+    for (size_t i = 0; i < size; ++i)
+        in->text[i] = words[i % (sizeof(words) - 1)];
+    for (size_t i = 0; i < 2 && i < size; ++i)
+    {
+        in->text[i] = ' ';
+        in->text[size - 1 - i] = ' ';
+    }
+    in->text[size] = '\0';
+    in->brin = brin_new_n(in->text, size);
+
+    /* Words are cut at single spaces so that joining restores the text. */
+    in->word_buffer = bench_alloc(size + 1);
+    memcpy(in->word_buffer, in->text, size + 1);
+    in->word_count = 1;
+    for (size_t i = 0; i < size; ++i)
+        in->word_count += in->text[i] == ' ';
+    in->words = bench_alloc(in->word_count * sizeof(*in->words));
+    size_t w = 0;
+    in->words[w++] = in->word_buffer;
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (in->word_buffer[i] == ' ')
+        {
+            in->word_buffer[i] = '\0';
+            in->words[w++] = in->word_buffer + i + 1;
+        }
+    }
+}
+
+static void input_destroy(struct Input *in)
+{
+    brin_destroy(&in->brin);
+    free(in->words);
+    free(in->word_buffer);
+    free(in->text);
+}
+
+/* Per-call state: a Brin to work on or to receive, or a split result. */
+union Slot
+{
+    Brin brin;
+    char **parts;
+};
+
+/*
+ * One benchmarked function. `prepare` fills each slot outside the timed
+ * region (NULL leaves it untouched), `run` makes one call per slot and
+ * `release` frees whatever the slot holds afterwards.
+ */
+struct Operation
+{
+    const char *name;
+    void (*prepare)(struct Input *in, union Slot *slot);
+    void (*run)(struct Input *in, union Slot *slots, size_t count);
+    void (*release)(union Slot *slot);
+};
+
+static void prepare_copy(struct Input *in, union Slot *slot)
+{
+    slot->brin = brin_new_n(in->text, in->size);
+}
+
+static void prepare_prefix(struct Input *in, union Slot *slot)
+{
+    (void)in;
+    slot->brin = brin_new("prefix:");
+}
+
+static void release_brin(union Slot *slot)
+{
+    brin_destroy(&slot->brin);
+}
+
+static void release_parts(union Slot *slot)
+{
+    for (char **p = slot->parts; *p; ++p) free(*p);
+    free(slot->parts);
+}
+
+static void run_new(struct Input *in, union Slot *slots, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) slots[i].brin = brin_new(in->text);
+}
+
+static void run_concat(struct Input *in, union Slot *slots, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) brin_concat(&slots[i].brin, in->text);
+}
+
+static void run_insert(struct Input *in, union Slot *slots, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        brin_insert(&slots[i].brin, (int)(in->size / 2), "inserted");
+}
+
+static void run_remove(struct Input *in, union Slot *slots, size_t count)
+{
+    int start = (int)(in->size / 4);
+    int end = (int)(in->size / 2);
+    for (size_t i = 0; i < count; ++i)
+        brin_remove(&slots[i].brin, start, end);
+}
+
+static void run_replace(struct Input *in, union Slot *slots, size_t count)
+{
+    (void)in;
+    for (size_t i = 0; i < count; ++i)
+        brin_replace(&slots[i].brin, "ipsum", "IPSUM!");
+}
+
+static void run_split(struct Input *in, union Slot *slots, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        slots[i].parts = brin_split(&in->brin, " ");
+}
+
+static void run_join(struct Input *in, union Slot *slots, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        slots[i].brin = brin_join(in->words, in->word_count, " ");
+}
+
+/* The needle never occurs, so every call scans the whole content. */
+static void run_index_of(struct Input *in, union Slot *slots, size_t count)
+{
+    volatile int sink = 0;
+    (void)slots;
+    for (size_t i = 0; i < count; ++i)
+        sink += brin_index_of(&in->brin, "zebra");
+    (void)sink;
+}
+
+static void run_to_lower(struct Input *in, union Slot *slots, size_t count)
+{
+    (void)in;
+    for (size_t i = 0; i < count; ++i) brin_to_lower(&slots[i].brin);
+}
+
+static void run_trim(struct Input *in, union Slot *slots, size_t count)
+{
+    (void)in;
+    for (size_t i = 0; i < count; ++i) brin_trim(&slots[i].brin);
+}
+
+static const struct Operation operations[] =
+{
+    { "new", NULL, run_new, release_brin },
+    { "concat", prepare_prefix, run_concat, release_brin },
+    { "insert", prepare_copy, run_insert, release_brin },
+    { "remove", prepare_copy, run_remove, release_brin },
+    { "replace", prepare_copy, run_replace, release_brin },
+    { "split", NULL, run_split, release_parts },
+    { "join", NULL, run_join, release_brin },
+    { "index_of", NULL, run_index_of, NULL },
+    { "to_lower", prepare_copy, run_to_lower, release_brin },
+    { "trim", prepare_copy, run_trim, release_brin },
+};
+
+struct Result
+{
+    size_t iterations;
+    double ns_per_op;
+    double bytes_per_sec;
+    double allocs_per_op;
+};
+
+/*
+ * Runs `op` in batches until the iteration count for this size is reached.
+ * Only the `run` calls are timed and counted; preparing and releasing the
+ * slots happens between them.
+ */
+static struct Result measure(const struct Operation *op, struct Input *in,
+                             union Slot *slots)
+{
+    size_t iterations = BENCH_TARGET_BYTES / in->size;
+    if (iterations > BENCH_MAX_ITERATIONS) iterations = BENCH_MAX_ITERATIONS;
+    if (iterations == 0) iterations = 1;
+    size_t batch = BENCH_BATCH_BYTES / in->size;
+    if (batch > BENCH_MAX_BATCH) batch = BENCH_MAX_BATCH;
+    if (batch == 0) batch = 1;
+
+    double elapsed = 0;
+    size_t allocs = 0;
+    for (size_t done = 0; done < iterations; done += batch)
+    {
+        size_t count = iterations - done < batch ? iterations - done : batch;
+        if (op->prepare)
+            for (size_t i = 0; i < count; ++i) op->prepare(in, &slots[i]);
+
+        size_t before = allocations;
+        double start = now_ns();
+        op->run(in, slots, count);
+        elapsed += now_ns() - start;
+        allocs += allocations - before;
+
+        if (op->release)
+            for (size_t i = 0; i < count; ++i) op->release(&slots[i]);
+    }
+
+    struct Result r;
+    r.iterations = iterations;
+    r.ns_per_op = elapsed / (double)iterations;
+    r.bytes_per_sec = r.ns_per_op > 0
+                      ? (double)in->size * 1e9 / r.ns_per_op : 0;
+    r.allocs_per_op = (double)allocs / (double)iterations;
+    return r;
+}
+
+static const char *format_size(size_t size, char *buffer, size_t capacity)
+{
+    if (size >= (1u << 20))
+        snprintf(buffer, capacity, "%zu MiB", size >> 20);
+    else if (size >= (1u << 10))
+        snprintf(buffer, capacity, "%zu KiB", size >> 10);
+    else
+        snprintf(buffer, capacity, "%zu B", size);
+    return buffer;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [--json] [--max-size BYTES] [--only NAME]\n",
+            program);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+    int json = 0;
+    size_t max_size = BENCH_MAX_SIZE;
+    const char *only = NULL;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+            json = 1;
+        else if (strcmp(argv[i], "--max-size") == 0 && i + 1 < argc)
+            max_size = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc)
+            only = argv[++i];
+        else
+            usage(argv[0]);
+    }
+
+    size_t op_count = sizeof(operations) / sizeof(operations[0]);
+    union Slot *slots = bench_alloc(BENCH_MAX_BATCH * sizeof(*slots));
+    int first = 1;
+
+    if (json)
+        printf("{\n  \"cpu_features\": %u,\n  \"results\": [",
+               brin_cpu_features());
+    else
+        printf("%-10s %10s %10s %14s %12s %10s\n", "operation", "size",
+               "iters", "ns/op", "MB/s", "allocs/op");
+
+    /* Sizes grow eightfold, with `max_size` itself always measured last. */
+    for (size_t size = BENCH_MIN_SIZE; size <= max_size;
+            size = size < max_size && size * 8 > max_size ? max_size : size * 8)
+    {
+        struct Input in;
+        input_init(&in, size);
+        for (size_t k = 0; k < op_count; ++k)
+        {
+            const struct Operation *op = &operations[k];
+            if (only && strcmp(only, op->name) != 0) continue;
+
+            struct Result r = measure(op, &in, slots);
+            if (json)
+            {
+                printf("%s\n    {\"op\": \"%s\", \"size\": %zu, "
+                       "\"iterations\": %zu, \"ns_per_op\": %.2f, "
+                       "\"bytes_per_sec\": %.0f, \"allocs_per_op\": %.2f}",
+                       first ? "" : ",", op->name, size, r.iterations,
+                       r.ns_per_op, r.bytes_per_sec, r.allocs_per_op);
+                first = 0;
+            }
+            else
+            {
+                char label[32];
+                printf("%-10s %10s %10zu %14.1f %12.1f %10.2f\n", op->name,
+                       format_size(size, label, sizeof(label)), r.iterations,
+                       r.ns_per_op, r.bytes_per_sec / 1e6, r.allocs_per_op);
+            }
+            fflush(stdout);
+        }
+        input_destroy(&in);
+    }
+
+    if (json) printf("\n  ]\n}\n");
+    free(slots);
+    return 0;
+}
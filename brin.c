@@ -27,639 +27,4973 @@
  * SOFTWARE.
  */
 
+/* mremap() and MADV_HUGEPAGE are Linux extensions. */
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
 #define _POSIX_C_SOURCE 200809L
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifndef BRIN_NO_ATOMICS
+#include <stdatomic.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <pthread.h>
+
+#if defined(__GNUC__) && defined(__SSE2__) \
+    && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BRIN_X86_DISPATCH
+#endif
+
+#if defined(__linux__) && !defined(BRIN_NO_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define BRIN_IO_URING
+#endif
+#endif
 
 #include "brin.h"
 
-/**
- * @brief Append a C-string suffix to a Brin string, resizing memory as needed.
- *
- * This function concatenates the null-terminated string `suffix`
- * to the end of the string held in `b`. It reallocates the internal
- * buffer to accommodate the new length, updating the stored length accordingly.
+#define BRIN_MAP_GROUP 16
+#define BRIN_MAP_EMPTY 0x80
+#define BRIN_MAP_DELETED 0xFE
+#define BRIN_IOV_BATCH 64
+#define BRIN_CSV_BLOCK 65536
+#define BRIN_LOAD_WINDOW 256
+#define BRIN_LOAD_THREADS 16
+
+/*
+ * Reference counts are C11 atomics so that shares of one buffer can live
+ * in different threads. Defining BRIN_NO_ATOMICS turns them into plain
+ * integers for single-threaded programs.
+ */
+#ifdef BRIN_NO_ATOMICS
+typedef size_t brin_refcount;
+
+static void brin_ref_init(brin_refcount *r, size_t value)
+{
+    *r = value;
+}
+
+static void brin_ref_acquire(brin_refcount *r)
+{
+    ++*r;
+}
+
+static int brin_ref_release(brin_refcount *r)
+{
+    return --*r == 0;
+}
+
+static size_t brin_ref_count(brin_refcount *r)
+{
+    return *r;
+}
+#else
+typedef atomic_size_t brin_refcount;
+
+static void brin_ref_init(brin_refcount *r, size_t value)
+{
+    atomic_init(r, value);
+}
+
+/* A new reference is always taken from an existing one: no ordering needed. */
+static void brin_ref_acquire(brin_refcount *r)
+{
+    atomic_fetch_add_explicit(r, 1, memory_order_relaxed);
+}
+
+/*
+ * Returns 1 when the last reference is dropped. The release decrement
+ * publishes this owner's accesses to the buffer, and the acquire fence
+ * makes all of them visible to the thread that frees it.
+ */
+static int brin_ref_release(brin_refcount *r)
+{
+    if (atomic_fetch_sub_explicit(r, 1, memory_order_release) != 1) return 0;
+    atomic_thread_fence(memory_order_acquire);
+    return 1;
+}
+
+/* Acquire pairs with the release decrements of owners that let go. */
+static size_t brin_ref_count(brin_refcount *r)
+{
+    return atomic_load_explicit(r, memory_order_acquire);
+}
+#endif
+
+/*
+ * Control block of a buffer shared by several Brins. Created by brin_share()
+ * and freed, with the buffer, when the last sharing Brin lets go of it.
+ * A buffer mapped by brin_map_file() always has one, with `mapped` set to
+ * the mapping length, so that any mutation copies it to the heap first.
+ * The anonymous mapping of brin_new_mapped() is `writable`: its sole owner
+ * appends to it in place and grows it with mremap().
+ */
+struct BrinShared
+{
+    brin_refcount refs;
+    char *base;
+    size_t mapped;
+    int writable;
+};
+
+/* Frees `heap`, or drops one reference to `shared` when it is set. */
+static void brin_release_storage(char *heap, struct BrinShared *shared)
+{
+    if (!shared)
+    {
+        free(heap);
+        return;
+    }
+    if (brin_ref_release(&shared->refs))
+    {
+        if (shared->mapped) munmap(shared->base, shared->mapped);
+        else free(shared->base);
+        free(shared);
+    }
+}
+
+/* Releases the buffer of `b`: frees it, or drops one reference if shared. */
+static void brin_drop_buffer(Brin *b)
+{
+    brin_release_storage(b->string, b->shared);
+    b->shared = NULL;
+}
+
+/*
+ * Piece appended by brin_concat_lazy(): borrowed bytes when both `heap` and
+ * `shared` are NULL, otherwise storage taken over from a Brin. A NULL
+ * `data` marks bytes of the Brin's own flattened prefix, kept as `offset`
+ * from `string` because flattening may move that buffer.
+ */
+struct BrinPiece
+{
+    const char *data;
+    size_t offset;
+    size_t length;
+    char *heap;
+    struct BrinShared *shared;
+};
+
+/* Returns the bytes of `piece`, a pending piece of `b`. */
+static const char *brin_piece_data(const Brin *b,
+                                   const struct BrinPiece *piece)
+{
+    return piece->data ? piece->data : b->string + piece->offset;
+}
+
+/*
+ * Pieces waiting to be appended to a Brin. Only appends are supported, so
+ * a flat array gives O(1) amortized insertion and a single pass to flatten.
+ */
+struct BrinCord
+{
+    struct BrinPiece *pieces;
+    size_t count;
+    size_t capacity;
+    size_t length;
+};
+
+static void brin_cord_free(struct BrinCord *cord)
+{
+    for (size_t i = 0; i < cord->count; ++i)
+        brin_release_storage(cord->pieces[i].heap, cord->pieces[i].shared);
+    free(cord->pieces);
+    free(cord);
+}
+
+static void brin_make_unique(Brin *b);
+
+/* Tells whether `b` alone owns a writable mapping, from its first byte. */
+static int brin_owns_mapping(Brin *b)
+{
+    return b->shared && b->shared->writable && b->string == b->shared->base
+           && brin_ref_count(&b->shared->refs) == 1;
+}
+
+/*
+ * Grows the writable mapping owned by `b` to at least `needed` bytes. On
+ * Linux, mremap() moves the pages instead of copying them.
+ */
+static void brin_grow_mapping(Brin *b, size_t needed)
+{
+    struct BrinShared *shared = b->shared;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = (needed + page - 1) / page * page;
+#if defined(MREMAP_MAYMOVE)
+    void *data = mremap(shared->base, shared->mapped, size, MREMAP_MAYMOVE);
+#else
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data != MAP_FAILED)
+    {
+        memcpy(data, shared->base, b->length + 1);
+        munmap(shared->base, shared->mapped);
+    }
+#endif
+    if (data == MAP_FAILED)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    shared->base = data;
+    shared->mapped = size;
+    b->string = data;
+    b->capacity = size;
+}
+
+/*
+ * Appends the pending pieces of `b` to its buffer in a single allocation,
+ * after which `string` holds all `length` bytes again.
+ */
+static void brin_flatten(Brin *b)
+{
+    if (!b->cord) return;
+    struct BrinCord *cord = b->cord;
+    size_t total = b->length;
+    b->cord = NULL;
+    b->length -= cord->length;
+
+    char *new_string;
+    if (brin_owns_mapping(b))
+    {
+        if (total + 1 > b->capacity) brin_grow_mapping(b, total + 1);
+        new_string = b->string;
+    }
+    else
+    {
+        brin_make_unique(b);
+        new_string = realloc(b->string, total + 1);
+        if (!new_string)
+        {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        b->capacity = total + 1;
+    }
+    char *out = new_string + b->length;
+    for (size_t i = 0; i < cord->count; ++i)
+    {
+        const char *data = cord->pieces[i].data
+                           ? cord->pieces[i].data
+                           : new_string + cord->pieces[i].offset;
+        memcpy(out, data, cord->pieces[i].length);
+        out += cord->pieces[i].length;
+    }
+    *out = '\0';
+    b->string = new_string;
+    b->length = total;
+    brin_cord_free(cord);
+}
+
+/*
+ * Flattens `b` like brin_flatten(), moving the byte arguments `*first` and
+ * `*second` (either may be NULL) along with the content when they point
+ * into the flattened prefix, as arguments taken from `b->string` while
+ * pieces are pending do.
+ */
+static void brin_flatten_args(Brin *b, const char **first,
+                              const char **second)
+{
+    if (!b->cord) return;
+    const char *old = b->string;
+    size_t prefix = b->length - b->cord->length;
+    const char **args[2] = { first, second };
+    size_t offsets[2] = { (size_t)-1, (size_t)-1 };
+    for (size_t i = 0; i < 2; ++i)
+        if (args[i] && *args[i] >= old && *args[i] < old + prefix)
+            offsets[i] = (size_t)(*args[i] - old);
+    brin_flatten(b);
+    for (size_t i = 0; i < 2; ++i)
+        if (offsets[i] != (size_t)-1) *args[i] = b->string + offsets[i];
+}
+
+/*
+ * Makes `b` the sole owner of a null-terminated buffer before a mutation,
+ * copying the bytes only if other Brins still share them. A shared
+ * substring that became the last owner is moved to the buffer start.
+ */
+static void brin_make_unique(Brin *b)
+{
+    brin_flatten(b);
+    if (!b->shared) return;
+    if (!b->shared->mapped && brin_ref_count(&b->shared->refs) == 1)
+    {
+        char *base = b->shared->base;
+        if (b->string != base) memmove(base, b->string, b->length);
+        base[b->length] = '\0';
+        b->string = base;
+        b->capacity = b->length + 1;
+        free(b->shared);
+        b->shared = NULL;
+        return;
+    }
+    char *copy = malloc(b->length + 1);
+    if (!copy)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, b->string, b->length);
+    copy[b->length] = '\0';
+    brin_drop_buffer(b);
+    b->string = copy;
+    b->capacity = b->length + 1;
+}
+
+/*
+ * Makes `b` the sole owner of a buffer of at least `needed` bytes, growing
+ * it geometrically so that repeated appends run in amortized O(1). A
+ * writable mapping stays in place and grows with brin_grow_mapping().
+ */
+static void brin_reserve(Brin *b, size_t needed)
+{
+    brin_flatten(b);
+    if (brin_owns_mapping(b))
+    {
+        if (needed > b->capacity)
+            brin_grow_mapping(b, needed > b->capacity * 2 ? needed
+                              : b->capacity * 2);
+        return;
+    }
+    brin_make_unique(b);
+    if (needed <= b->capacity) return;
+    size_t capacity = b->capacity * 2;
+    if (capacity < needed) capacity = needed;
+    char *new_string = realloc(b->string, capacity);
+    if (!new_string)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    b->string = new_string;
+    b->capacity = capacity;
+}
+
+/*
+ * Gives `b` a null-terminated string. Only shared substrings and mapped
+ * files can lack the terminator; reading one byte past a substring stays
+ * inside the parent buffer, but the end of a mapping is never read.
+ */
+static void brin_terminate(Brin *b)
+{
+    brin_flatten(b);
+    struct BrinShared *shared = b->shared;
+    if (shared && shared->mapped
+            && b->string + b->length == shared->base + shared->mapped)
+        brin_make_unique(b);
+    else if (b->string[b->length] != '\0')
+        brin_make_unique(b);
+}
+
+/* Returns the index of the lowest set bit of a non-zero mask. */
+static unsigned brin_lowest_bit(unsigned mask)
+{
+    unsigned i = 0;
+    while (!(mask & 1u))
+    {
+        mask >>= 1;
+        i++;
+    }
+    return i;
+}
+
+/*
+ * Delimiter set of a split: a lookup table for every byte, plus the
+ * distinct bytes themselves so that SIMD kernels can compare against them.
+ */
+struct BrinDelims
+{
+    unsigned char table[256];
+    unsigned char set[16];
+    size_t count;
+};
+
+/*
+ * Hot loops with SIMD variants. Every entry is resolved once, from the
+ * features of the running CPU, to the best kernel built into the library;
+ * all variants of an entry give the same results.
+ */
+struct BrinKernels
+{
+    const char *(*find)(const char *hay, size_t hay_len,
+                        const char *needle, size_t needle_len);
+    size_t (*find_delim)(const char *s, size_t len, const struct BrinDelims *d);
+    void (*case_map)(char *s, size_t len, int upper);
+    size_t (*span_space)(const char *s, size_t len);
+    size_t (*rspan_space)(const char *s, size_t len);
+    void (*csv_masks)(const unsigned char *block, unsigned char delimiter,
+                      uint64_t *quotes, uint64_t *delimiters,
+                      uint64_t *newlines);
+};
+
+static const struct BrinKernels *brin_kernels(void);
+
+/*
+ * Returns the first occurrence of needle[0..needle_len) in hay[0..hay_len),
+ * or NULL. Candidates are located with memchr on the first byte.
+ */
+static const char *brin_find_scalar(const char *hay, size_t hay_len,
+                                    const char *needle, size_t needle_len)
+{
+    if (needle_len == 0) return hay;
+    if (needle_len > hay_len) return NULL;
+    const char *last = hay + (hay_len - needle_len);
+    const char *p = hay;
+    while (p <= last)
+    {
+        p = memchr(p, needle[0], (size_t)(last - p) + 1);
+        if (!p) return NULL;
+        if (memcmp(p + 1, needle + 1, needle_len - 1) == 0) return p;
+        p++;
+    }
+    return NULL;
+}
+
+/* Returns the index of the first delimiter byte in s[0..len), or len. */
+static size_t brin_find_delim_scalar(const char *s, size_t len,
+                                     const struct BrinDelims *d)
+{
+    size_t i = 0;
+    while (i < len && !d->table[(unsigned char)s[i]]) i++;
+    return i;
+}
+
+/* Maps s[0..len) through toupper or tolower. */
+static void brin_case_map_scalar(char *s, size_t len, int upper)
+{
+    for (size_t i = 0; i < len; ++i)
+    {
+        unsigned char c = (unsigned char)s[i];
+        s[i] = (char)(upper ? toupper(c) : tolower(c));
+    }
+}
+
+/* Returns the number of leading bytes of s[0..len) that are isspace. */
+static size_t brin_span_space_scalar(const char *s, size_t len)
+{
+    size_t i = 0;
+    while (i < len && isspace((unsigned char)s[i])) i++;
+    return i;
+}
+
+/* Returns `len` minus the number of trailing bytes that are isspace. */
+static size_t brin_rspan_space_scalar(const char *s, size_t len)
+{
+    while (len > 0 && isspace((unsigned char)s[len - 1])) len--;
+    return len;
+}
+
+/* Sets the bits of the quotes, delimiters and newlines of a 64-byte block. */
+static void brin_csv_masks_scalar(const unsigned char *block,
+                                  unsigned char delimiter, uint64_t *quotes,
+                                  uint64_t *delimiters, uint64_t *newlines)
+{
+    *quotes = *delimiters = *newlines = 0;
+    for (unsigned i = 0; i < 64; ++i)
+    {
+        uint64_t bit = (uint64_t)1 << i;
+        if (block[i] == '"') *quotes |= bit;
+        if (block[i] == delimiter) *delimiters |= bit;
+        if (block[i] == '\n') *newlines |= bit;
+    }
+}
+
+#if defined(__SSE2__)
+/*
+ * SSE2 kernels, 16 bytes at a time. Bytes of 0x80 and above may be
+ * classified differently by the current locale, so chunks holding any are
+ * left to the scalar kernels; ASCII is mapped the same in every locale the
+ * callers let through.
+ */
+static const char *brin_find_sse2(const char *hay, size_t hay_len,
+                                  const char *needle, size_t needle_len)
+{
+    if (needle_len < 2 || needle_len > hay_len)
+        return brin_find_scalar(hay, hay_len, needle, needle_len);
+    __m128i first = _mm_set1_epi8(needle[0]);
+    __m128i last = _mm_set1_epi8(needle[needle_len - 1]);
+    size_t i = 0;
+    for (; i + needle_len + 15 <= hay_len; i += 16)
+    {
+        __m128i head = _mm_loadu_si128((const __m128i *)(hay + i));
+        __m128i tail = _mm_loadu_si128((const __m128i *)(hay + i + needle_len - 1));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+                            _mm_and_si128(_mm_cmpeq_epi8(head, first),
+                                          _mm_cmpeq_epi8(tail, last)));
+        while (mask)
+        {
+            unsigned bit = brin_lowest_bit(mask);
+            if (memcmp(hay + i + bit + 1, needle + 1, needle_len - 2) == 0)
+                return hay + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return brin_find_scalar(hay + i, hay_len - i, needle, needle_len);
+}
+
+static size_t brin_find_delim_sse2(const char *s, size_t len,
+                                   const struct BrinDelims *d)
+{
+    if (d->count == 0) return len;
+    if (d->count > 4) return brin_find_delim_scalar(s, len, d);
+    __m128i set[4];
+    for (size_t k = 0; k < 4; ++k)
+        set[k] = _mm_set1_epi8((char)d->set[k < d->count ? k : 0]);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i hit = _mm_or_si128(
+                          _mm_or_si128(_mm_cmpeq_epi8(chunk, set[0]),
+                                       _mm_cmpeq_epi8(chunk, set[1])),
+                          _mm_or_si128(_mm_cmpeq_epi8(chunk, set[2]),
+                                       _mm_cmpeq_epi8(chunk, set[3])));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+        if (mask) return i + brin_lowest_bit(mask);
+    }
+    return i + brin_find_delim_scalar(s + i, len - i, d);
+}
+
+static void brin_case_map_sse2(char *s, size_t len, int upper)
+{
+    __m128i low = _mm_set1_epi8(upper ? 'a' - 1 : 'A' - 1);
+    __m128i high = _mm_set1_epi8(upper ? 'z' + 1 : 'Z' + 1);
+    __m128i flip = _mm_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+        if (_mm_movemask_epi8(chunk))
+        {
+            brin_case_map_scalar(s + i, 16, upper);
+            continue;
+        }
+        __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(chunk, low),
+                                        _mm_cmplt_epi8(chunk, high));
+        chunk = _mm_xor_si128(chunk, _mm_and_si128(letters, flip));
+        _mm_storeu_si128((__m128i *)(s + i), chunk);
+    }
+    brin_case_map_scalar(s + i, len - i, upper);
+}
+
+/* Mask of the bytes of `chunk` that are ' ' or in '\t'..'\r'. */
+static unsigned brin_space_mask_sse2(__m128i chunk)
+{
+    __m128i shifted = _mm_sub_epi8(chunk, _mm_set1_epi8('\t'));
+    __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)),
+                                     shifted);
+    __m128i blank = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+    return (unsigned)_mm_movemask_epi8(_mm_or_si128(control, blank));
+}
+
+static size_t brin_span_space_sse2(const char *s, size_t len)
+{
+    size_t i = 0;
+    while (i + 16 <= len)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+        if (brin_space_mask_sse2(chunk) != 0xFFFF)
+        {
+            size_t n = brin_span_space_scalar(s + i, 16);
+            if (n < 16) return i + n;
+        }
+        i += 16;
+    }
+    return i + brin_span_space_scalar(s + i, len - i);
+}
+
+static size_t brin_rspan_space_sse2(const char *s, size_t len)
+{
+    while (len >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s + len - 16));
+        if (brin_space_mask_sse2(chunk) != 0xFFFF)
+        {
+            size_t n = brin_rspan_space_scalar(s + len - 16, 16);
+            if (n > 0) return len - 16 + n;
+        }
+        len -= 16;
+    }
+    return brin_rspan_space_scalar(s, len);
+}
+
+static void brin_csv_masks_sse2(const unsigned char *block,
+                                unsigned char delimiter, uint64_t *quotes,
+                                uint64_t *delimiters, uint64_t *newlines)
+{
+    __m128i quote = _mm_set1_epi8('"');
+    __m128i delim = _mm_set1_epi8((char)delimiter);
+    __m128i newline = _mm_set1_epi8('\n');
+    *quotes = *delimiters = *newlines = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(block + 16 * i));
+        unsigned shift = 16 * i;
+        *quotes |= (uint64_t)(unsigned)_mm_movemask_epi8(
+                       _mm_cmpeq_epi8(chunk, quote)) << shift;
+        *delimiters |= (uint64_t)(unsigned)_mm_movemask_epi8(
+                           _mm_cmpeq_epi8(chunk, delim)) << shift;
+        *newlines |= (uint64_t)(unsigned)_mm_movemask_epi8(
+                         _mm_cmpeq_epi8(chunk, newline)) << shift;
+    }
+}
+#endif
+
+#if defined(BRIN_X86_DISPATCH)
+/*
+ * SSE4.2 and AVX2 kernels, compiled for those instruction sets whatever the
+ * build flags and only called when the CPU reports them.
+ */
+__attribute__((target("sse4.2")))
+static size_t brin_find_delim_sse42(const char *s, size_t len,
+                                    const struct BrinDelims *d)
+{
+    if (d->count > 16) return brin_find_delim_scalar(s, len, d);
+    __m128i set = _mm_loadu_si128((const __m128i *)d->set);
+    int set_len = (int)d->count;
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+        int at = _mm_cmpestri(set, set_len, chunk, 16,
+                              _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY
+                              | _SIDD_LEAST_SIGNIFICANT);
+        if (at < 16) return i + (size_t)at;
+    }
+    return i + brin_find_delim_scalar(s + i, len - i, d);
+}
+
+__attribute__((target("avx2")))
+static const char *brin_find_avx2(const char *hay, size_t hay_len,
+                                  const char *needle, size_t needle_len)
+{
+    if (needle_len < 2 || needle_len > hay_len)
+        return brin_find_scalar(hay, hay_len, needle, needle_len);
+    __m256i first = _mm256_set1_epi8(needle[0]);
+    __m256i last = _mm256_set1_epi8(needle[needle_len - 1]);
+    size_t i = 0;
+    for (; i + needle_len + 31 <= hay_len; i += 32)
+    {
+        __m256i head = _mm256_loadu_si256((const __m256i *)(hay + i));
+        __m256i tail = _mm256_loadu_si256(
+                           (const __m256i *)(hay + i + needle_len - 1));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+                            _mm256_and_si256(_mm256_cmpeq_epi8(head, first),
+                                             _mm256_cmpeq_epi8(tail, last)));
+        while (mask)
+        {
+            unsigned bit = brin_lowest_bit(mask);
+            if (memcmp(hay + i + bit + 1, needle + 1, needle_len - 2) == 0)
+                return hay + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return brin_find_sse2(hay + i, hay_len - i, needle, needle_len);
+}
+
+__attribute__((target("avx2")))
+static size_t brin_find_delim_avx2(const char *s, size_t len,
+                                   const struct BrinDelims *d)
+{
+    if (d->count == 0) return len;
+    if (d->count > 4) return brin_find_delim_sse42(s, len, d);
+    __m256i set[4];
+    for (size_t k = 0; k < 4; ++k)
+        set[k] = _mm256_set1_epi8((char)d->set[k < d->count ? k : 0]);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i hit = _mm256_or_si256(
+                          _mm256_or_si256(_mm256_cmpeq_epi8(chunk, set[0]),
+                                          _mm256_cmpeq_epi8(chunk, set[1])),
+                          _mm256_or_si256(_mm256_cmpeq_epi8(chunk, set[2]),
+                                          _mm256_cmpeq_epi8(chunk, set[3])));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+        if (mask) return i + brin_lowest_bit(mask);
+    }
+    return i + brin_find_delim_sse2(s + i, len - i, d);
+}
+
+__attribute__((target("avx2")))
+static void brin_case_map_avx2(char *s, size_t len, int upper)
+{
+    __m256i low = _mm256_set1_epi8(upper ? 'a' - 1 : 'A' - 1);
+    __m256i high = _mm256_set1_epi8(upper ? 'z' + 1 : 'Z' + 1);
+    __m256i flip = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(s + i));
+        if (_mm256_movemask_epi8(chunk))
+        {
+            brin_case_map_scalar(s + i, 32, upper);
+            continue;
+        }
+        __m256i letters = _mm256_and_si256(_mm256_cmpgt_epi8(chunk, low),
+                                           _mm256_cmpgt_epi8(high, chunk));
+        chunk = _mm256_xor_si256(chunk, _mm256_and_si256(letters, flip));
+        _mm256_storeu_si256((__m256i *)(s + i), chunk);
+    }
+    brin_case_map_sse2(s + i, len - i, upper);
+}
+
+__attribute__((target("avx2")))
+static unsigned brin_space_mask_avx2(__m256i chunk)
+{
+    __m256i shifted = _mm256_sub_epi8(chunk, _mm256_set1_epi8('\t'));
+    __m256i control = _mm256_cmpeq_epi8(
+                          _mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+    __m256i blank = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' '));
+    return (unsigned)_mm256_movemask_epi8(_mm256_or_si256(control, blank));
+}
+
+__attribute__((target("avx2")))
+static size_t brin_span_space_avx2(const char *s, size_t len)
+{
+    size_t i = 0;
+    while (i + 32 <= len)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(s + i));
+        if (brin_space_mask_avx2(chunk) != 0xFFFFFFFFu)
+        {
+            size_t n = brin_span_space_scalar(s + i, 32);
+            if (n < 32) return i + n;
+        }
+        i += 32;
+    }
+    return i + brin_span_space_sse2(s + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t brin_rspan_space_avx2(const char *s, size_t len)
+{
+    while (len >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(s + len - 32));
+        if (brin_space_mask_avx2(chunk) != 0xFFFFFFFFu)
+        {
+            size_t n = brin_rspan_space_scalar(s + len - 32, 32);
+            if (n > 0) return len - 32 + n;
+        }
+        len -= 32;
+    }
+    return brin_rspan_space_sse2(s, len);
+}
+
+__attribute__((target("avx2")))
+static void brin_csv_masks_avx2(const unsigned char *block,
+                                unsigned char delimiter, uint64_t *quotes,
+                                uint64_t *delimiters, uint64_t *newlines)
+{
+    __m256i quote = _mm256_set1_epi8('"');
+    __m256i delim = _mm256_set1_epi8((char)delimiter);
+    __m256i newline = _mm256_set1_epi8('\n');
+    __m256i lo = _mm256_loadu_si256((const __m256i *)block);
+    __m256i hi = _mm256_loadu_si256((const __m256i *)(block + 32));
+    *quotes = (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, quote))
+              | (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, quote)) << 32;
+    *delimiters = (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, delim))
+                  | (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, delim)) << 32;
+    *newlines = (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, newline))
+                | (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, newline)) << 32;
+}
+#endif
+
+/* Kernels selected once from the CPU and BRIN_CPU, and their feature bits. */
+static unsigned brin_features;
+static struct BrinKernels brin_kernel_table;
+
+/* Returns the CPU features of the running machine that the library can use. */
+static unsigned brin_detect_features(void)
+{
+    unsigned features = 0;
+#if defined(BRIN_X86_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) features |= BRIN_CPU_SSE2;
+    if (__builtin_cpu_supports("sse4.2")) features |= BRIN_CPU_SSE42;
+    if (__builtin_cpu_supports("avx2")) features |= BRIN_CPU_AVX2;
+#elif defined(__SSE2__)
+    features |= BRIN_CPU_SSE2;
+#endif
+    return features;
+}
+
+/*
+ * Keeps the features up to the level named by BRIN_CPU ("scalar", "sse2",
+ * "sse4.2" or "avx2"), so that kernels can be compared on one machine.
+ * Unknown values leave the features unchanged.
+ */
+static unsigned brin_limit_features(unsigned features, const char *level)
+{
+    if (!level) return features;
+    unsigned allowed;
+    if (strcmp(level, "scalar") == 0) allowed = 0;
+    else if (strcmp(level, "sse2") == 0) allowed = BRIN_CPU_SSE2;
+    else if (strcmp(level, "sse4.2") == 0)
+        allowed = BRIN_CPU_SSE2 | BRIN_CPU_SSE42;
+    else if (strcmp(level, "avx2") == 0)
+        allowed = BRIN_CPU_SSE2 | BRIN_CPU_SSE42 | BRIN_CPU_AVX2;
+    else return features;
+    return features & allowed;
+}
+
+static void brin_resolve_kernels(void)
+{
+    unsigned f = brin_limit_features(brin_detect_features(), getenv("BRIN_CPU"));
+    unsigned used = 0;
+    struct BrinKernels k =
+    {
+        brin_find_scalar, brin_find_delim_scalar, brin_case_map_scalar,
+        brin_span_space_scalar, brin_rspan_space_scalar, brin_csv_masks_scalar
+    };
+    (void)f;
+#if defined(__SSE2__)
+    if (f & BRIN_CPU_SSE2)
+    {
+        used |= BRIN_CPU_SSE2;
+        k.find = brin_find_sse2;
+        k.find_delim = brin_find_delim_sse2;
+        k.case_map = brin_case_map_sse2;
+        k.span_space = brin_span_space_sse2;
+        k.rspan_space = brin_rspan_space_sse2;
+        k.csv_masks = brin_csv_masks_sse2;
+    }
+#endif
+#if defined(BRIN_X86_DISPATCH)
+    if ((f & BRIN_CPU_SSE2) && (f & BRIN_CPU_SSE42))
+    {
+        used |= BRIN_CPU_SSE42;
+        k.find_delim = brin_find_delim_sse42;
+    }
+    if ((f & BRIN_CPU_SSE2) && (f & BRIN_CPU_SSE42) && (f & BRIN_CPU_AVX2))
+    {
+        used |= BRIN_CPU_AVX2;
+        k.find = brin_find_avx2;
+        k.find_delim = brin_find_delim_avx2;
+        k.case_map = brin_case_map_avx2;
+        k.span_space = brin_span_space_avx2;
+        k.rspan_space = brin_rspan_space_avx2;
+        k.csv_masks = brin_csv_masks_avx2;
+    }
+#endif
+    brin_features = used;
+    brin_kernel_table = k;
+}
+
+#if defined(__GNUC__)
+/*
+ * Resolves the kernels when the library is loaded, ahead of constructors
+ * without a priority, so that looking them up costs a single load.
+ */
+__attribute__((constructor(101)))
+static void brin_init_kernels(void)
+{
+    brin_resolve_kernels();
+}
+
+static const struct BrinKernels *brin_kernels(void)
+{
+    return &brin_kernel_table;
+}
+#else
+static pthread_once_t brin_kernels_once = PTHREAD_ONCE_INIT;
+
+static const struct BrinKernels *brin_kernels(void)
+{
+    pthread_once(&brin_kernels_once, brin_resolve_kernels);
+    return &brin_kernel_table;
+}
+#endif
+
+/*
+ * Maps s[0..len) through toupper or tolower. The SIMD kernels convert ASCII
+ * letters directly, which matches every locale except those, like Turkish,
+ * that map 'i' and 'I' differently; those get the scalar kernel.
+ */
+static void brin_case_map(char *s, size_t len, int upper)
+{
+    if (toupper('i') == 'I' && tolower('I') == 'i')
+        brin_kernels()->case_map(s, len, upper);
+    else
+        brin_case_map_scalar(s, len, upper);
+}
+
+/*
+ * Returns the first occurrence of needle[0..needle_len) in hay[0..hay_len),
+ * or NULL, using the best search kernel for this CPU.
+ */
+static const char *brin_find(const char *hay, size_t hay_len,
+                             const char *needle, size_t needle_len)
+{
+    return brin_kernels()->find(hay, hay_len, needle, needle_len);
+}
+
+/* Builds the delimiter set of the null-terminated string `sep`. */
+static void brin_delimiters(const char *sep, struct BrinDelims *d)
+{
+    memset(d->table, 0, sizeof(d->table));
+    memset(d->set, 0, sizeof(d->set));
+    d->count = 0;
+    for (; *sep; ++sep)
+    {
+        unsigned char c = (unsigned char)*sep;
+        if (d->table[c]) continue;
+        d->table[c] = 1;
+        if (d->count < sizeof(d->set)) d->set[d->count] = c;
+        d->count++;
+    }
+}
+
+/*
+ * Finds the next token of s[0..len) from *pos, skipping runs of delimiter
+ * bytes like strtok does. Returns 0 when no token is left.
+ */
+static int brin_next_token(const char *s, size_t len, size_t *pos,
+                           const struct BrinDelims *d,
+                           size_t *start, size_t *token_len)
+{
+    size_t i = *pos;
+    while (i < len && d->table[(unsigned char)s[i]]) i++;
+    if (i == len)
+    {
+        *pos = len;
+        return 0;
+    }
+    *start = i;
+    i += brin_kernels()->find_delim(s + i, len - i, d);
+    *token_len = i - *start;
+    *pos = i;
+    return 1;
+}
+
+/* Returns a null-terminated heap copy of s[0..len). */
+static char *brin_strndup(const char *s, size_t len)
+{
+    char *copy = malloc(len + 1);
+    if (!copy)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+/* Creates the control block of `b` on first share and adds a reference. */
+static void brin_share_buffer(Brin *b)
+{
+    brin_flatten(b);
+    if (!b->shared)
+    {
+        b->shared = malloc(sizeof(*b->shared));
+        if (!b->shared)
+        {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        brin_ref_init(&b->shared->refs, 1);
+        b->shared->base = b->string;
+        b->shared->mapped = 0;
+        b->shared->writable = 0;
+    }
+    brin_ref_acquire(&b->shared->refs);
+}
+
+/**
+ * @brief Append a C-string suffix to a Brin string, resizing memory as needed.
+ *
+ * This function concatenates the null-terminated string `suffix`
+ * to the end of the string held in `b`. It reallocates the internal
+ * buffer to accommodate the new length, updating the stored length accordingly.
+ *
+ * @param[in,out] b Pointer to the Brin instance to modify.
+ * @param[in] suffix Null-terminated string to append.
+ *
+ * @pre Both `b` and `suffix` must not be NULL, and `b->string` must be valid.
+ *
+ * @note The function will exit the program if any input is NULL
+ *       or if memory allocation fails.
+ */
+void brin_concat(Brin *b, const char *suffix)
+{
+    if (!suffix)
+    {
+        fprintf(stderr, "Error: one of the input is null\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_concat_n(b, suffix, strlen(suffix));
+}
+
+/**
+ * @brief Append `length` bytes to a Brin string, resizing memory as needed.
+ *
+ * Same as brin_concat() without measuring the suffix: the bytes are copied
+ * as-is, including any null byte. The suffix may point inside `b` itself.
+ *
+ * @param[in,out] b Pointer to the Brin instance to modify.
+ * @param[in] suffix Bytes to append (may be NULL only if `length` is 0).
+ * @param[in] length Number of bytes to append.
+ *
+ * @note The function will exit the program if any input is NULL
+ *       or if memory allocation fails.
+ */
+void brin_concat_n(Brin *b, const char *suffix, size_t length)
+{
+    if (!b || !b->string || (!suffix && length))
+    {
+        fprintf(stderr, "Error: one of the input is null\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_flatten_args(b, &suffix, NULL);
+    size_t self_offset = (size_t)-1;
+    if (suffix >= b->string && suffix < b->string + b->length)
+        self_offset = (size_t)(suffix - b->string);
+
+    size_t new_length = b->length + length;
+    brin_reserve(b, new_length + 1);
+    if (self_offset != (size_t)-1) suffix = b->string + self_offset;
+    if (length) memcpy(b->string + b->length, suffix, length);
+    b->string[new_length] = '\0';
+    b->length = new_length;
+    b->hash = 0;
+}
+
+/**
+ * @brief Check if the Brin string contains a given substring.
+ *
+ * This function searches for the first occurrence of the null-terminated
+ * string `string` inside the Brin's internal string.
+ *
+ * @param[in] b Pointer to the Brin instance to check.
+ * @param[in] string Null-terminated substring to search for.
+ *
+ * @return 1 if the substring is found, 0 otherwise.
+ *
+ * @pre Both `b` and `string` must not be NULL, and `b->string` must be valid.
+ *
+ * @note The function will exit the program if any input is NULL.
+ */
+int brin_contains(Brin *b, const char *string)
+{
+    if (!string)
+    {
+        fprintf(stderr, "Error: one of the input is null\n");
+        exit(EXIT_FAILURE);
+    }
+    return brin_contains_n(b, string, strlen(string));
+}
+
+/**
+ * @brief Check if the Brin string contains a given sequence of bytes.
+ *
+ * Same as brin_contains() with an explicit substring length, so the
+ * substring may contain null bytes.
+ *
+ * @param[in] b Pointer to the Brin instance to check.
+ * @param[in] string Bytes to search for (may be NULL only if `length` is 0).
+ * @param[in] length Number of bytes to search for.
+ *
+ * @return 1 if the substring is found, 0 otherwise.
+ *
+ * @note The function will exit the program if any input is NULL.
+ */
+int brin_contains_n(Brin *b, const char *string, size_t length)
+{
+    return brin_index_of_n(b, string, length) != -1;
+}
+
+/**
+ * @brief Compare the Brin string with a null-terminated string for equality.
+ *
+ * This function checks if the Brin's internal string is exactly equal
+ * to the provided null-terminated string `string`.
+ *
+ * @param[in] b Pointer to the Brin instance.
+ * @param[in] string Null-terminated string to compare with.
+ *
+ * @return 1 if both strings are equal, 0 otherwise.
+ *
+ * @pre Neither `b`, `b->string`, nor `string` can be NULL.
+ *
+ * @note The function terminates the program if any input pointer is NULL.
+ */
+int brin_equals(Brin *b, const char *string)
+{
+    if (!string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    return brin_equals_n(b, string, strlen(string));
+}
+
+/**
+ * @brief Compare the Brin string with a sequence of bytes for equality.
+ *
+ * Lengths are compared first, so strings of different lengths are told
+ * apart without reading them.
+ *
+ * @param[in] b Pointer to the Brin instance.
+ * @param[in] string Bytes to compare with (may be NULL only if `length` is 0).
+ * @param[in] length Number of bytes to compare with.
+ *
+ * @return 1 if both hold the same bytes, 0 otherwise.
+ *
+ * @note The function terminates the program if any input pointer is NULL.
+ */
+int brin_equals_n(Brin *b, const char *string, size_t length)
+{
+    if (!b || !b->string || (!string && length))
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    if (b->length != length) return 0;
+    brin_flatten_args(b, &string, NULL);
+    return length == 0 || memcmp(b->string, string, length) == 0;
+}
+
+/**
+ * @brief Finds the first occurrence index of a substring within the Brin string.
+ *
+ * This function searches for the first occurrence of the null-terminated substring
+ * `string` inside the Brin's internal string.
+ *
+ * @param[in] b Pointer to the Brin instance.
+ * @param[in] string Null-terminated substring to search for.
+ *
+ * @return The zero-based index of the first occurrence of `string` inside `b->string`,
+ *         or -1 if the substring is not found.
+ *
+ * @pre Neither `b`, `b->string`, nor `string` can be NULL.
+ *
+ * @note The function terminates the program if any input pointer is NULL.
+ */
+int brin_index_of(Brin *b, const char *string)
+{
+    if (!string)
+    {
+        fprintf(stderr, "Error: one of the input is null\n");
+        exit(EXIT_FAILURE);
+    }
+    return brin_index_of_n(b, string, strlen(string));
+}
+
+/**
+ * @brief Finds the first occurrence index of a sequence of bytes within the Brin string.
+ *
+ * Same as brin_index_of() with an explicit substring length, so the
+ * substring may contain null bytes.
+ *
+ * @param[in] b Pointer to the Brin instance.
+ * @param[in] string Bytes to search for (may be NULL only if `length` is 0).
+ * @param[in] length Number of bytes to search for.
+ *
+ * @return The zero-based index of the first occurrence, or -1 if not found.
+ *
+ * @note The function terminates the program if any input pointer is NULL.
+ */
+int brin_index_of_n(Brin *b, const char *string, size_t length)
+{
+    if (!b || !b->string || (!string && length))
+    {
+        fprintf(stderr, "Error: one of the input is null\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_flatten_args(b, &string, NULL);
+    const char *index = brin_find(b->string, b->length, string, length);
+    if (index) return (int)(index - b->string);
+    return -1;
+}
+
+/**
+ * @brief Inserts a substring into the Brin string at a specified index.
+ *
+ * This function inserts the null-terminated substring `string` into the Brin's
+ * internal string at the zero-based position `index`.
+ *
+ * @param[in,out] b Pointer to the Brin instance.
+ * @param[in] index Position at which to insert the substring (0 ≤ index ≤ b->length).
+ * @param[in] string Null-terminated substring to insert.
+ *
+ * @pre Neither `b`, `b->string`, nor `string` can be NULL.
+ * @pre `index` must be within the valid range [0, b->length].
+ *
+ * @note The function will allocate new memory for the combined string, free the
+ *       old string, and update the length accordingly.
+ * @note The function terminates the program if inputs are invalid or memory allocation fails.
+ */
+void brin_insert(Brin *b, int index, const char *string)
+{
+    if (!string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_insert_n(b, index, string, strlen(string));
+}
+
+/**
+ * @brief Inserts a sequence of bytes into the Brin string at a specified index.
+ *
+ * Same as brin_insert() with an explicit length, so the inserted bytes may
+ * contain null bytes. They may also point inside `b` itself.
+ *
+ * @param[in,out] b Pointer to the Brin instance.
+ * @param[in] index Position at which to insert the bytes (0 ≤ index ≤ b->length).
+ * @param[in] string Bytes to insert (may be NULL only if `length` is 0).
+ * @param[in] length Number of bytes to insert.
+ *
+ * @note The function terminates the program if inputs are invalid or memory allocation fails.
+ */
+void brin_insert_n(Brin *b, int index, const char *string, size_t length)
+{
+    if (!b || !b->string || (!string && length))
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    if (index < 0 || index > (int)b->length)
+    {
+        fprintf(stderr, "Error: invalid index position\n");
+        exit(EXIT_FAILURE);
+    }
+
+    brin_flatten_args(b, &string, NULL);
+    size_t new_length = b->length + length;
+
+    char *new_string = malloc(new_length + 1);
+    if (!new_string)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memcpy(new_string, b->string, index);
+    if (length) memcpy(new_string + index, string, length);
+    memcpy(new_string + index + length, b->string + index,
+           b->length - index);
+    new_string[new_length] = '\0';
+
+    brin_drop_buffer(b);
+    b->string = new_string;
+    b->length = new_length;
+    b->capacity = new_length + 1;
+    b->hash = 0;
+}
+
+/**
+ * @brief Checks if the Brin string is empty.
+ *
+ * Returns 1 if the string length is zero, otherwise returns 0.
+ *
+ * @param[in] b Pointer to the Brin instance.
+ *
+ * @return 1 if the string is empty, 0 otherwise.
+ *
+ * @pre Neither `b` nor `b->string` can be NULL.
+ * @note The function terminates the program if inputs are invalid.
+ */
+int brin_is_empty(Brin *b)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    return b->length == 0;
+}
+
+/**
+ * @brief Checks if the Brin string consists only of whitespace characters.
+ *
+ * Returns 1 if all characters in the string are whitespace according to
+ * the standard C `isspace` function, otherwise returns 0.
+ *
+ * @param[in] b Pointer to the Brin instance.
+ *
+ * @return 1 if the string is non-empty and contains only whitespace characters,
+ *         0 otherwise.
+ *
+ * @pre Neither `b` nor `b->string` can be NULL.
+ * @note The function terminates the program if inputs are invalid.
+ */
+int brin_is_whitespace(Brin *b)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    if (b->length == 0) return 0;
+    brin_flatten(b);
+    return brin_kernels()->span_space(b->string, b->length) == b->length;
+}
+
+/**
+ * @brief Converts all characters in the Brin string to lowercase.
+ *
+ * Modifies the string in-place, converting each character to its lowercase
+ * equivalent using the standard C `tolower` function.
+ *
+ * @param[in,out] b Pointer to the Brin instance.
+ *
+ * @pre Neither `b` nor `b->string` can be NULL.
+ * @note The function terminates the program if inputs are invalid.
+ */
+void brin_to_lower(Brin *b)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_make_unique(b);
+    brin_case_map(b->string, b->length, 0);
+    b->hash = 0;
+}
+
+/**
+ * @brief Converts all characters in the Brin string to uppercase.
+ *
+ * Modifies the string in-place, converting each character to its uppercase
+ * equivalent using the standard C `toupper` function.
+ *
+ * @param[in,out] b Pointer to the Brin instance.
+ *
+ * @pre Neither `b` nor `b->string` can be NULL.
+ * @note The function terminates the program if inputs are invalid.
+ */
+void brin_to_upper(Brin *b)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_make_unique(b);
+    brin_case_map(b->string, b->length, 1);
+    b->hash = 0;
+}
+
+/**
+ * @brief Removes leading whitespace characters from the Brin string.
+ *
+ * Moves the start pointer past any whitespace characters and shifts the
+ * remaining string to the beginning. Then reallocates memory to shrink
+ * the buffer to the new trimmed length.
+ *
+ * @param[in,out] b Pointer to the Brin instance.
+ *
+ * @pre Neither `b` nor `b->string` can be NULL.
+ * @note The function terminates the program if inputs are invalid or
+ *       if memory reallocation fails.
+ */
+void brin_trim_start(Brin *b)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: input is null\n");
+        exit(EXIT_FAILURE);
+    }
+
+    brin_make_unique(b);
+    size_t start = brin_kernels()->span_space(b->string, b->length);
+
+    size_t new_len = b->length - start;
+    memmove(b->string, b->string + start, new_len + 1);
+    char *new_str = realloc(b->string, new_len + 1);
+    if (!new_str)
+    {
+        fprintf(stderr, "Error: realloc failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    b->string = new_str;
+    b->length = new_len;
+    b->capacity = new_len + 1;
+    b->hash = 0;
+}
+
+/**
+ * @brief Removes trailing whitespace characters from the Brin string.
+ *
+ * Scans backward from the end of the string, truncates the string
+ * at the last non-whitespace character, and reallocates memory
+ * to shrink the buffer to the new trimmed length.
+ *
+ * @param[in,out] b Pointer to the Brin instance.
+ *
+ * @pre Neither `b` nor `b->string` can be NULL.
+ * @note The function terminates the program if inputs are invalid or
+ *       if memory reallocation fails.
+ */
+void brin_trim_end(Brin *b)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: input is null\n");
+        exit(EXIT_FAILURE);
+    }
+
+    brin_make_unique(b);
+    size_t new_len = brin_kernels()->rspan_space(b->string, b->length);
+
+    b->string[new_len] = '\0';
+
+    char *new_str = realloc(b->string, new_len + 1);
+    if (!new_str)
+    {
+        fprintf(stderr, "Error: realloc failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    b->string = new_str;
+    b->length = new_len;
+    b->capacity = new_len + 1;
+    b->hash = 0;
+}
+
+/**
+ * @brief Removes leading and trailing whitespace characters from the Brin string.
+ *
+ * Calls brin_trim_end to remove trailing spaces, then brin_trim_start
+ * to remove leading spaces, effectively trimming the string on both ends.
+ *
+ * @param[in,out] b Pointer to the Brin instance.
+ */
+void brin_trim(Brin *b)
+{
+    brin_trim_end(b);
+    brin_trim_start(b);
+}
+
+/**
+ * @brief Removes a portion of the string from a Brin object.
+ *
+ * This function removes the characters in the range [start, end) from the Brin's string.
+ * The operation is performed in-place: the string is modified and reallocated accordingly.
+ *
+ * @param b Pointer to the Brin object to modify.
+ * @param start The starting index (inclusive) of the portion to remove.
+ * @param end The ending index (exclusive) of the portion to remove.
+ *
+ * @note If the input is invalid (e.g., NULL pointer, invalid indices), the function
+ *       prints an error message to stderr and exits with failure.
+ * @note The function allocates a new string and frees the old one. The caller does not need to free anything manually.
+ */
+void brin_remove(Brin *b, int start, int end)
+{
+    if (!b || !b->string || start < 0 || end < start || end > (int)b->length)
+    {
+        fprintf(stderr, "Error: invalid input\n");
+        exit(EXIT_FAILURE);
+    }
+
+    brin_flatten(b);
+    int new_len = b->length - (end - start);
+    char *new_str = malloc(new_len + 1);
+    if (!new_str)
+        return;
+
+    memcpy(new_str, b->string, start);
+    memcpy(new_str + start, b->string + end, b->length - end);
+    new_str[new_len] = '\0';
+
+    brin_drop_buffer(b);
+
+    b->string = new_str;
+    b->length = new_len;
+    b->capacity = new_len + 1;
+    b->hash = 0;
+}
+
+/**
+ * @brief Replaces all occurrences of a substring within a Brin string.
+ *
+ * Iterates through the Brin's string, finds each occurrence of `to_replace`,
+ * removes that segment, and inserts `replace_by` in its place. Continues until
+ * no more occurrences are found.
+ *
+ * @param b            Pointer to the Brin object to modify.
+ * @param to_replace   The substring to search for and replace.
+ * @param replace_by   The substring to insert in place of each found occurrence.
+ *
+ * @note Exits with failure if any input pointer is NULL or `to_replace` is empty.
+ * @note Occurrences are located first and the result is built in a single
+ *       allocation, see brin_replace_n().
+ */
+void brin_replace(Brin *b, const char *to_replace, const char *replace_by)
+{
+    if (!b || !to_replace || !replace_by || !*to_replace)
+    {
+        fprintf(stderr, "Error: invalid input\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_replace_n(b, to_replace, strlen(to_replace), replace_by,
+                   strlen(replace_by));
+}
+
+/**
+ * @brief Replaces all occurrences of a sequence of bytes within a Brin string.
+ *
+ * Same as brin_replace() with explicit lengths. Occurrences are found from
+ * left to right without overlapping, counted in a first pass, and the
+ * result is built in a single allocation in a second pass.
+ *
+ * @param b              Pointer to the Brin object to modify.
+ * @param to_replace     Bytes to search for and replace.
+ * @param to_replace_len Number of bytes in `to_replace` (must not be 0).
+ * @param replace_by     Bytes to insert in place of each occurrence.
+ * @param replace_by_len Number of bytes in `replace_by`.
+ *
+ * @note Exits with failure if any input pointer is NULL, `to_replace_len` is 0,
+ *       or memory allocation fails.
+ */
+void brin_replace_n(Brin *b, const char *to_replace, size_t to_replace_len,
+                    const char *replace_by, size_t replace_by_len)
+{
+    if (!b || !b->string || !to_replace || !to_replace_len ||
+            (!replace_by && replace_by_len))
+    {
+        fprintf(stderr, "Error: invalid input\n");
+        exit(EXIT_FAILURE);
+    }
+
+    brin_flatten_args(b, &to_replace, &replace_by);
+    const char *end = b->string + b->length;
+    size_t count = 0;
+    for (const char *p = b->string;
+            (p = brin_find(p, (size_t)(end - p), to_replace, to_replace_len));
+            p += to_replace_len)
+        count++;
+    if (count == 0) return;
+
+    size_t new_length = b->length - count * to_replace_len +
+                        count * replace_by_len;
+    char *new_string = malloc(new_length + 1);
+    if (!new_string)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    char *out = new_string;
+    const char *p = b->string;
+    const char *match;
+    while ((match = brin_find(p, (size_t)(end - p), to_replace,
+                              to_replace_len)))
+    {
+        memcpy(out, p, (size_t)(match - p));
+        out += match - p;
+        if (replace_by_len) memcpy(out, replace_by, replace_by_len);
+        out += replace_by_len;
+        p = match + to_replace_len;
+    }
+    memcpy(out, p, (size_t)(end - p));
+    new_string[new_length] = '\0';
+
+    brin_drop_buffer(b);
+    b->string = new_string;
+    b->length = new_length;
+    b->capacity = new_length + 1;
+    b->hash = 0;
+}
+
+/**
+ * @brief Splits the string inside a Brin object into a NULL-terminated array of strings.
+ *
+ * This function takes a Brin pointer and a separator string, then splits the Brin's string
+ * by occurrences of the separator. It returns a dynamically allocated NULL-terminated array
+ * of strings, each string is separately allocated and must be freed by the caller.
+ *
+ * As with `strtok`, every byte of `sep` is a delimiter, runs of delimiters are collapsed
+ * and empty tokens are skipped. The content is scanned up to `b->length`, so null bytes
+ * inside it are kept in the tokens (which then read as shorter C strings).
+ *
+ * @param b Pointer to the Brin object containing the string to split.
+ * @param sep The separator string used to split the input string.
+ *
+ * @return A NULL-terminated array of dynamically allocated strings resulting from the split.
+ *
+ * @note The caller is responsible for freeing each string in the returned array,
+ *       as well as the array pointer itself.
+ * @note The function will exit with failure if input pointers are NULL or memory allocation fails.
+ */
+char **brin_split(Brin *b, const char *sep)
+{
+    if (!b || !b->string || !sep)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+
+    struct BrinDelims delims;
+    brin_delimiters(sep, &delims);
+    brin_flatten(b);
+
+    size_t count = 0;
+    size_t pos = 0, start, len;
+    while (brin_next_token(b->string, b->length, &pos, &delims, &start, &len))
+        count++;
+
+    char **array = malloc((count + 1) * sizeof(char*));
+    if (!array)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t i = 0;
+    pos = 0;
+    while (brin_next_token(b->string, b->length, &pos, &delims, &start, &len))
+        array[i++] = brin_strndup(b->string + start, len);
+    array[i] = NULL;
+    return array;
+}
+
+/**
+ * @brief Splits the content of a Brin into at most `max_fields` strings.
+ *
+ * Tokens follow the same rules as brin_split() until `max_fields - 1`
+ * tokens have been found. The last field then holds the unsplit remainder,
+ * starting at its first non-delimiter byte, and the rest of the content is
+ * never scanned. A `max_fields` of 0 means no limit.
+ *
+ * @param b          Pointer to the Brin instance to split.
+ * @param sep        The null-terminated set of delimiter bytes.
+ * @param max_fields Maximum number of fields to return, or 0 for no limit.
+ * @return A NULL-terminated array of dynamically allocated strings.
+ *
+ * @note The caller is responsible for freeing each string in the returned array,
+ *       as well as the array pointer itself.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+char **brin_split_n(Brin *b, const char *sep, size_t max_fields)
+{
+    if (!b || !b->string || !sep)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+
+    struct BrinDelims delims;
+    brin_delimiters(sep, &delims);
+    brin_flatten(b);
+
+    size_t count = 0;
+    size_t pos = 0, start, len;
+    while ((max_fields == 0 || count < max_fields)
+           && brin_next_token(b->string, b->length, &pos, &delims, &start, &len))
+        count++;
+
+    char **array = malloc((count + 1) * sizeof(char*));
+    if (!array)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pos = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        brin_next_token(b->string, b->length, &pos, &delims, &start, &len);
+        if (i + 1 == max_fields) len = b->length - start;
+        array[i] = brin_strndup(b->string + start, len);
+    }
+    array[count] = NULL;
+    return array;
+}
+
+/**
+ * @brief Splits the content of a Brin into a NULL-terminated array held in one allocation.
+ *
+ * Tokens follow the same rules as brin_split(), but the pointer array and
+ * every null-terminated token are laid out in a single block, sized exactly
+ * after a counting pass: the tokens are stored right after the array.
+ *
+ * @param b   Pointer to the Brin instance to split.
+ * @param sep The null-terminated set of delimiter bytes.
+ * @return A NULL-terminated array of tokens.
+ *
+ * @note Release the result with brin_split_free() or a single free(); the
+ *       tokens must not be freed individually.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+char **brin_split_packed(Brin *b, const char *sep)
+{
+    if (!b || !b->string || !sep)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+
+    struct BrinDelims delims;
+    brin_delimiters(sep, &delims);
+    brin_flatten(b);
+
+    size_t count = 0, bytes = 0;
+    size_t pos = 0, start, len;
+    while (brin_next_token(b->string, b->length, &pos, &delims, &start, &len))
+    {
+        count++;
+        bytes += len + 1;
+    }
+
+    char **array = malloc((count + 1) * sizeof(char*) + bytes);
+    if (!array)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    char *out = (char *)(array + count + 1);
+    size_t i = 0;
+    pos = 0;
+    while (brin_next_token(b->string, b->length, &pos, &delims, &start, &len))
+    {
+        memcpy(out, b->string + start, len);
+        out[len] = '\0';
+        array[i++] = out;
+        out += len + 1;
+    }
+    array[i] = NULL;
+    return array;
+}
+
+/**
+ * @brief Frees an array returned by brin_split_packed().
+ *
+ * @param array The array to free (may be NULL).
+ */
+void brin_split_free(char **array)
+{
+    free(array);
+}
+
+/**
+ * @brief Frees the memory used by the string in the Brin instance and resets its state.
+ *
+ * This function releases the allocated memory for the string inside the given Brin object,
+ * sets the string pointer to NULL, and resets the length to zero.
+ * If the BRIN_LITE mode is not enabled, it also clears all function pointers to avoid dangling references.
+ *
+ * @param b Pointer to the Brin instance to destroy.
+ */
+void brin_destroy(Brin *b)
+{
+    if (b && b->string) brin_drop_buffer(b);
+    if (b->cord) brin_cord_free(b->cord);
+    b->string = NULL;
+    b->capacity = 0;
+    b->shared = NULL;
+    b->cord = NULL;
+    b->length = 0;
+    b->hash = 0;
+#ifndef BRIN_LITE
+    b->destroy = NULL;
+    b->concat = NULL;
+    b->contains = NULL;
+    b->equals = NULL;
+    b->index_of = NULL;
+    b->insert = NULL;
+    b->is_empty = NULL;
+    b->is_whitespace = NULL;
+    b->to_lower = NULL;
+    b->to_upper = NULL;
+    b->trim_start = NULL;
+    b->trim_end = NULL;
+    b->trim = NULL;
+    b->split = NULL;
+    b->remove = NULL;
+    b->replace = NULL;
+#endif
+}
+
+/* Points the function table of `b` at the library functions. */
+static void brin_bind_methods(Brin *b)
+{
+#ifndef BRIN_LITE
+    b->destroy = brin_destroy;
+    b->concat = brin_concat;
+    b->contains = brin_contains;
+    b->equals = brin_equals;
+    b->index_of = brin_index_of;
+    b->insert = brin_insert;
+    b->is_empty = brin_is_empty;
+    b->is_whitespace = brin_is_whitespace;
+    b->to_lower = brin_to_lower;
+    b->to_upper = brin_to_upper;
+    b->trim_start = brin_trim_start;
+    b->trim_end = brin_trim_end;
+    b->trim = brin_trim;
+    b->split = brin_split;
+    b->remove = brin_remove;
+    b->replace = brin_replace;
+#else
+    (void)b;
+#endif
+}
+
+/**
+ * @brief Creates a new Brin instance initialized with the given string.
+ *
+ * Allocates memory for the string, copies the input string into the newly created Brin,
+ * initializes the length field, and sets function pointers if BRIN_LITE mode is not active.
+ *
+ * @param string The C-string to initialize the Brin with. Must not be NULL.
+ * @return A Brin instance containing a copy of the input string.
+ *
+ * @note This function exits the program with an error if the input string is NULL
+ *       or if memory allocation fails.
+ */
+Brin brin_new(const char *string)
+{
+    if (!string)
+    {
+        fprintf(stderr, "Error: null string input\n");
+        exit(EXIT_FAILURE);
+    }
+    return brin_new_n(string, strlen(string));
+}
+
+/**
+ * @brief Creates a new Brin instance initialized with `length` bytes.
+ *
+ * Same as brin_new() without measuring the input: exactly `length` bytes
+ * are copied, including any null byte, and a terminator is appended.
+ *
+ * @param string The bytes to copy (may be NULL only if `length` is 0).
+ * @param length Number of bytes to copy.
+ * @return A Brin instance containing a copy of the bytes.
+ *
+ * @note This function exits the program with an error if the input is invalid
+ *       or if memory allocation fails.
+ */
+Brin brin_new_n(const char *string, size_t length)
+{
+    if (!string && length)
+    {
+        fprintf(stderr, "Error: null string input\n");
+        exit(EXIT_FAILURE);
+    }
+    Brin b;
+    b.length = length;
+    b.string = malloc(length + 1);
+    if (!b.string)
+    {
+        fprintf(stderr, "Error: memory allocation\n");
+        exit(EXIT_FAILURE);
+    }
+    if (length) memcpy(b.string, string, length);
+    b.string[length] = '\0';
+    b.capacity = length + 1;
+    b.hash = 0;
+    b.shared = NULL;
+    b.cord = NULL;
+    brin_bind_methods(&b);
+    return b;
+}
+
+/**
+ * @brief Joins an array of C strings into a single Brin, separated by `sep`.
+ *
+ * @param array  Array of C strings to join.
+ * @param length Number of elements in the array.
+ * @param sep    Separator string (can be empty, but not NULL).
+ * @return Brin  The joined string.
+ */
+Brin brin_join(const char **array, size_t length, const char *sep)
+{
+    if (!sep)
+    {
+        fprintf(stderr, "Error: separator is NULL\n");
+        exit(EXIT_FAILURE);
+    }
+    return brin_join_n(array, NULL, length, sep, strlen(sep));
+}
+
+/**
+ * @brief Joins an array of byte sequences into a single Brin, separated by `sep`.
+ *
+ * The total length is computed first, so the result is built in a single
+ * allocation. C strings are then copied up to their terminator instead of
+ * being measured a second time.
+ *
+ * @param array   Array of byte sequences to join.
+ * @param lengths Length of each element, or NULL if the elements are C strings.
+ * @param count   Number of elements in the array.
+ * @param sep     Separator bytes (may be NULL only if `sep_len` is 0).
+ * @param sep_len Number of bytes in the separator.
+ * @return Brin   The joined string.
+ *
+ * @note The function exits the program if an input is NULL or memory allocation fails.
+ */
+Brin brin_join_n(const char **array, const size_t *lengths, size_t count,
+                 const char *sep, size_t sep_len)
+{
+    if (!array)
+    {
+        fprintf(stderr, "Error: input array is NULL\n");
+        exit(EXIT_FAILURE);
+    }
+    if (!sep && sep_len)
+    {
+        fprintf(stderr, "Error: separator is NULL\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t total = count ? (count - 1) * sep_len : 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!array[i] && (!lengths || lengths[i]))
+        {
+            fprintf(stderr, "Error: array[%zu] is NULL\n", i);
+            exit(EXIT_FAILURE);
+        }
+        total += lengths ? lengths[i] : strlen(array[i]);
+    }
+
+    char *string = malloc(total + 1);
+    if (!string)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    char *out = string;
+    char *end = string + total;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (lengths)
+        {
+            if (lengths[i]) memcpy(out, array[i], lengths[i]);
+            out += lengths[i];
+        }
+        else
+        {
+            /* Copying up to the terminator measures the string too. */
+            char *next = memccpy(out, array[i], '\0', (size_t)(end - out) + 1);
+            out = next ? next - 1 : end;
+        }
+        if (i + 1 < count && sep_len)
+        {
+            memcpy(out, sep, sep_len);
+            out += sep_len;
+        }
+    }
+    string[total] = '\0';
+
+    Brin b;
+    b.string = string;
+    b.length = total;
+    b.capacity = total + 1;
+    b.hash = 0;
+    b.shared = NULL;
+    b.cord = NULL;
+    brin_bind_methods(&b);
+    return b;
+}
+
+/**
+ * @brief Returns a view over the whole content of a Brin.
+ *
+ * @param b Pointer to the Brin instance.
+ * @return A BrinView covering `b->string` and `b->length`.
+ *
+ * @note The function terminates the program if inputs are invalid.
+ */
+BrinView brin_view(Brin *b)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_flatten(b);
+    BrinView v = { b->string, b->length };
+    return v;
+}
+
+/**
+ * @brief Returns a view over `length` bytes starting at `data`.
+ *
+ * @param data   Pointer to the first byte (may be NULL only if `length` is 0).
+ * @param length Number of bytes in the span.
+ * @return A BrinView covering the span.
+ */
+BrinView brin_view_n(const char *data, size_t length)
+{
+    if (!data && length)
+    {
+        fprintf(stderr, "Error: null data with non-zero length\n");
+        exit(EXIT_FAILURE);
+    }
+    BrinView v = { data ? data : "", length };
+    return v;
+}
+
+/* Loads 8 bytes as a little-endian word, whatever the host byte order. */
+static uint64_t brin_load_le64(const char *s)
+{
+    uint64_t v;
+    memcpy(&v, s, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+/* SWAR check that the 8 bytes at `s` are all ASCII digits. */
+static int brin_is_eight_digits(const char *s)
+{
+    uint64_t v = brin_load_le64(s);
+    return (((v & 0xF0F0F0F0F0F0F0F0ULL) |
+             (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+            0x3333333333333333ULL);
+}
+
+/* SWAR conversion of 8 ASCII digits to their value, in 3 multiplications. */
+static uint32_t brin_eight_digits_value(const char *s)
+{
+    uint64_t v = brin_load_le64(s) - 0x3030303030303030ULL;
+    v = (v * 10) + (v >> 8);
+    v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+         (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    return (uint32_t)v;
+}
+
+static int brin_is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/*
+ * Accumulates the digits of s[i..len) into *value and returns the index of
+ * the first non-digit. *overflow is set if the value does not fit 64 bits.
+ */
+static size_t brin_scan_u64(const char *s, size_t i, size_t len,
+                            uint64_t *value, int *overflow)
+{
+    uint64_t v = 0;
+    *overflow = 0;
+    while (len - i >= 8 && brin_is_eight_digits(s + i) &&
+            v <= (UINT64_MAX - 99999999ULL) / 100000000ULL)
+    {
+        v = v * 100000000ULL + brin_eight_digits_value(s + i);
+        i += 8;
+    }
+    while (i < len && brin_is_digit(s[i]))
+    {
+        unsigned digit = (unsigned)(s[i] - '0');
+        if (v > (UINT64_MAX - digit) / 10) *overflow = 1;
+        else v = v * 10 + digit;
+        i++;
+    }
+    *value = v;
+    return i;
+}
+
+/**
+ * @brief Parses a signed 64-bit decimal integer from the start of a view.
+ *
+ * Accepts an optional `+` or `-` sign followed by decimal digits. Leading
+ * whitespace is not skipped and parsing never reads past `v.length`.
+ * The result does not depend on the current locale.
+ *
+ * @param v   The span to parse.
+ * @param out Receives the parsed value, saturated to INT64_MIN/INT64_MAX on overflow.
+ * @param end If not NULL, receives the number of bytes consumed (0 if no digits).
+ *
+ * @return 1 on success, 0 if no digits were found or the value overflows.
+ */
+int brin_parse_i64(BrinView v, int64_t *out, size_t *end)
+{
+    if (!out || (!v.data && v.length))
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t i = 0;
+    int negative = 0;
+    if (i < v.length && (v.data[i] == '+' || v.data[i] == '-'))
+    {
+        negative = v.data[i] == '-';
+        i++;
+    }
+    uint64_t magnitude;
+    int overflow;
+    size_t stop = brin_scan_u64(v.data, i, v.length, &magnitude, &overflow);
+    *out = 0;
+    if (end) *end = stop == i ? 0 : stop;
+    if (stop == i) return 0;
+
+    uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+    if (overflow || magnitude > limit)
+    {
+        *out = negative ? INT64_MIN : INT64_MAX;
+        return 0;
+    }
+    if (negative)
+        *out = magnitude == limit ? INT64_MIN : -(int64_t)magnitude;
+    else
+        *out = (int64_t)magnitude;
+    return 1;
+}
+
+/**
+ * @brief Parses an unsigned 64-bit decimal integer from the start of a view.
+ *
+ * Accepts an optional `+` sign followed by decimal digits. Leading
+ * whitespace is not skipped and parsing never reads past `v.length`.
+ * The result does not depend on the current locale.
+ *
+ * @param v   The span to parse.
+ * @param out Receives the parsed value, saturated to UINT64_MAX on overflow.
+ * @param end If not NULL, receives the number of bytes consumed (0 if no digits).
+ *
+ * @return 1 on success, 0 if no digits were found or the value overflows.
+ */
+int brin_parse_u64(BrinView v, uint64_t *out, size_t *end)
+{
+    if (!out || (!v.data && v.length))
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t i = 0;
+    if (i < v.length && v.data[i] == '+') i++;
+    int overflow;
+    size_t stop = brin_scan_u64(v.data, i, v.length, out, &overflow);
+    if (end) *end = stop == i ? 0 : stop;
+    if (stop == i)
+    {
+        *out = 0;
+        return 0;
+    }
+    if (overflow)
+    {
+        *out = UINT64_MAX;
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Accumulates the digits of s[i..len) into *mantissa while they fit in 19
+ * significant digits, and returns the index of the first non-digit.
+ * *kept and *dropped count the digits that were and were not accumulated.
+ */
+static size_t brin_scan_mantissa(const char *s, size_t i, size_t len,
+                                 uint64_t *mantissa, int *digits,
+                                 size_t *kept, size_t *dropped)
+{
+    while (*mantissa == 0 && i < len && s[i] == '0')
+    {
+        i++;
+        (*kept)++;
+    }
+    while (*digits <= 11 && len - i >= 8 && brin_is_eight_digits(s + i))
+    {
+        *mantissa = *mantissa * 100000000ULL + brin_eight_digits_value(s + i);
+        *digits += 8;
+        *kept += 8;
+        i += 8;
+    }
+    while (i < len && brin_is_digit(s[i]))
+    {
+        if (*digits < 19)
+        {
+            *mantissa = *mantissa * 10 + (uint64_t)(s[i] - '0');
+            if (*mantissa) (*digits)++;
+            (*kept)++;
+        }
+        else
+        {
+            (*dropped)++;
+        }
+        i++;
+    }
+    return i;
+}
+
+/* Case-insensitive match of the ASCII lowercase `word` at s[i..len). */
+static int brin_match_word(const char *s, size_t i, size_t len,
+                           const char *word)
+{
+    size_t n = strlen(word);
+    if (len - i < n) return 0;
+    for (size_t k = 0; k < n; ++k)
+    {
+        if (tolower((unsigned char)s[i + k]) != word[k]) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Slow path for literals that cannot be converted exactly with one double
+ * operation: hands a bounded copy to strtod, using the locale's decimal point.
+ */
+static double brin_strtod_bounded(const char *s, size_t len)
+{
+    const char *point = localeconv()->decimal_point;
+    size_t point_len = strlen(point);
+    char stack[64];
+    char *buf = stack;
+    size_t need = len * point_len + 1;
+    if (need > sizeof(stack))
+    {
+        buf = malloc(need);
+        if (!buf)
+        {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < len; ++i)
+    {
+        if (s[i] == '.')
+        {
+            memcpy(buf + n, point, point_len);
+            n += point_len;
+        }
+        else
+        {
+            buf[n++] = s[i];
+        }
+    }
+    buf[n] = '\0';
+    double value = strtod(buf, NULL);
+    if (buf != stack) free(buf);
+    return value;
+}
+
+/**
+ * @brief Parses a decimal floating-point number from the start of a view.
+ *
+ * Accepts `[+-]digits[.digits][(e|E)[+-]digits]` as well as `inf`,
+ * `infinity` and `nan` (case-insensitive). The decimal separator is always `.`,
+ * whatever the current locale. Leading whitespace is not skipped and parsing
+ * never reads past `v.length`.
+ *
+ * Literals with at most 19 significant digits, a mantissa below 2^53 and a
+ * decimal exponent within [-22, 22] are converted exactly with a single
+ * multiplication or division; other literals fall back to `strtod`.
+ *
+ * @param v   The span to parse.
+ * @param out Receives the correctly rounded value (±inf or 0 when out of range).
+ * @param end If not NULL, receives the number of bytes consumed (0 if no number).
+ *
+ * @return 1 on success, 0 if no number was found.
+ */
+int brin_parse_double(BrinView v, double *out, size_t *end)
+{
+    static const double powers[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    if (!out || (!v.data && v.length))
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    const char *s = v.data;
+    size_t len = v.length;
+    size_t i = 0;
+    int negative = 0;
+    *out = 0.0;
+    if (end) *end = 0;
+
+    if (i < len && (s[i] == '+' || s[i] == '-'))
+    {
+        negative = s[i] == '-';
+        i++;
+    }
+
+    if (brin_match_word(s, i, len, "inf"))
+    {
+        i += brin_match_word(s, i, len, "infinity") ? 8 : 3;
+        *out = negative ? -INFINITY : INFINITY;
+        if (end) *end = i;
+        return 1;
+    }
+    if (brin_match_word(s, i, len, "nan"))
+    {
+        *out = negative ? -NAN : NAN;
+        if (end) *end = i + 3;
+        return 1;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    size_t int_kept = 0, int_dropped = 0;
+    size_t frac_kept = 0, frac_dropped = 0;
+
+    i = brin_scan_mantissa(s, i, len, &mantissa, &digits,
+                           &int_kept, &int_dropped);
+    if (i < len && s[i] == '.')
+    {
+        size_t frac_start = i + 1;
+        size_t stop = brin_scan_mantissa(s, frac_start, len, &mantissa,
+                                         &digits, &frac_kept, &frac_dropped);
+        if (stop > frac_start || int_kept + int_dropped > 0) i = stop;
+    }
+    if (int_kept + int_dropped + frac_kept + frac_dropped == 0) return 0;
+
+    int64_t exponent = 0;
+    if (i < len && (s[i] == 'e' || s[i] == 'E'))
+    {
+        size_t j = i + 1;
+        int exp_negative = 0;
+        if (j < len && (s[j] == '+' || s[j] == '-'))
+        {
+            exp_negative = s[j] == '-';
+            j++;
+        }
+        if (j < len && brin_is_digit(s[j]))
+        {
+            while (j < len && brin_is_digit(s[j]))
+            {
+                if (exponent < 100000) exponent = exponent * 10 + (s[j] - '0');
+                j++;
+            }
+            if (exp_negative) exponent = -exponent;
+            i = j;
+        }
+    }
+    if (end) *end = i;
+
+    int64_t scale = exponent + (int64_t)int_dropped - (int64_t)frac_kept;
+    int exact = int_dropped + frac_dropped == 0;
+    if (!exact || mantissa > (1ULL << 53) || scale < -22 || scale > 22)
+    {
+        *out = mantissa == 0 && exact ? 0.0 : brin_strtod_bounded(s, i);
+        if (*out == 0.0 && negative) *out = -0.0;
+        return 1;
+    }
+    double value = scale < 0 ? (double)mantissa / powers[-scale]
+                   : (double)mantissa * powers[scale];
+    *out = negative ? -value : value;
+    return 1;
+}
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 brin_u128;
+#endif
+
+/* 64x64 -> 128-bit multiplication, low half in *a and high half in *b. */
+static void brin_mum(uint64_t *a, uint64_t *b)
+{
+#if defined(__SIZEOF_INT128__)
+    brin_u128 r = (brin_u128)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32;
+    uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static uint64_t brin_mix(uint64_t a, uint64_t b)
+{
+    brin_mum(&a, &b);
+    return a ^ b;
+}
+
+static uint64_t brin_load_le32(const char *s)
+{
+    uint32_t v;
+    memcpy(&v, s, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+/* SWAR ASCII lowercase of 8 bytes: sets bit 5 of every byte in 'A'..'Z'. */
+static uint64_t brin_fold_ascii64(uint64_t w)
+{
+    uint64_t heptets = w & 0x7F7F7F7F7F7F7F7FULL;
+    uint64_t ge_a = heptets + 0x3F3F3F3F3F3F3F3FULL;
+    uint64_t gt_z = heptets + 0x2525252525252525ULL;
+    uint64_t upper = ~w & (ge_a ^ gt_z) & 0x8080808080808080ULL;
+    return w | (upper >> 2);
+}
+
+static uint64_t brin_hash_read64(const char *p, int fold)
+{
+    uint64_t v = brin_load_le64(p);
+    return fold ? brin_fold_ascii64(v) : v;
+}
+
+static uint64_t brin_hash_read32(const char *p, int fold)
+{
+    uint64_t v = brin_load_le32(p);
+    return fold ? brin_fold_ascii64(v) : v;
+}
+
+static uint64_t brin_hash_read_byte(const char *p, int fold)
+{
+    uint64_t v = (unsigned char)*p;
+    return fold ? brin_fold_ascii64(v) : v;
+}
+
+/*
+ * wyhash (final version 4): three independent 64-bit multiply-mix lanes
+ * over 48-byte blocks, passes SMHasher and runs at several GB/s.
+ * With `fold` set, ASCII letters are lowercased as they are loaded.
+ */
+static uint64_t brin_hash_bytes(const char *p, size_t len, uint64_t seed,
+                                int fold)
+{
+    static const uint64_t secret[4] =
+    {
+        0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+        0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+    };
+    uint64_t a, b;
+
+    seed ^= brin_mix(seed ^ secret[0], secret[1]);
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            size_t step = (len >> 3) << 2;
+            a = (brin_hash_read32(p, fold) << 32) |
+                brin_hash_read32(p + step, fold);
+            b = (brin_hash_read32(p + len - 4, fold) << 32) |
+                brin_hash_read32(p + len - 4 - step, fold);
+        }
+        else if (len > 0)
+        {
+            a = (brin_hash_read_byte(p, fold) << 16) |
+                (brin_hash_read_byte(p + (len >> 1), fold) << 8) |
+                brin_hash_read_byte(p + len - 1, fold);
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        size_t i = len;
+        if (i >= 48)
+        {
+            uint64_t see1 = seed, see2 = seed;
+            do
+            {
+                seed = brin_mix(brin_hash_read64(p, fold) ^ secret[1],
+                                brin_hash_read64(p + 8, fold) ^ seed);
+                see1 = brin_mix(brin_hash_read64(p + 16, fold) ^ secret[2],
+                                brin_hash_read64(p + 24, fold) ^ see1);
+                see2 = brin_mix(brin_hash_read64(p + 32, fold) ^ secret[3],
+                                brin_hash_read64(p + 40, fold) ^ see2);
+                p += 48;
+                i -= 48;
+            }
+            while (i >= 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16)
+        {
+            seed = brin_mix(brin_hash_read64(p, fold) ^ secret[1],
+                            brin_hash_read64(p + 8, fold) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = brin_hash_read64(p + i - 16, fold);
+        b = brin_hash_read64(p + i - 8, fold);
+    }
+    a ^= secret[1];
+    b ^= seed;
+    brin_mum(&a, &b);
+    return brin_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+/* Returns the cached hash of `b`, computing it first if needed. */
+static uint64_t brin_cached_hash(Brin *b)
+{
+    brin_flatten(b);
+    if (b->hash == 0) b->hash = brin_hash_bytes(b->string, b->length, 0, 0);
+    return b->hash;
+}
+
+/**
+ * @brief Compare two Brin strings for equality.
+ *
+ * Compares the lengths first, then the cached hashes (computing and caching
+ * them if needed), and only runs a byte comparison when both match.
+ * Repeatedly comparing the same Brin against many candidates therefore
+ * hashes it once and rejects most candidates in constant time.
+ *
+ * @param[in,out] a Pointer to the first Brin instance.
+ * @param[in,out] b Pointer to the second Brin instance.
+ *
+ * @return 1 if both strings hold the same bytes, 0 otherwise.
+ *
+ * @pre Neither `a`, `b`, nor their strings can be NULL.
+ * @note The function terminates the program if any input pointer is NULL.
+ */
+int brin_equals_brin(Brin *a, Brin *b)
+{
+    if (!a || !a->string || !b || !b->string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    if (a->length != b->length) return 0;
+    brin_flatten(a);
+    brin_flatten(b);
+    if (a->string == b->string) return 1;
+    if (brin_cached_hash(a) != brin_cached_hash(b)) return 0;
+    return memcmp(a->string, b->string, a->length) == 0;
+}
+
+/**
+ * @brief Returns the 64-bit hash of a Brin's content, caching it in `b->hash`.
+ *
+ * The hash is wyhash, a fast well-distributed non-cryptographic hash, with
+ * seed 0. It equals `brin_hash64_seeded(brin_view(b), 0)`, so views and
+ * Brins with the same bytes hash identically.
+ *
+ * @param[in,out] b Pointer to the Brin instance.
+ * @return The hash of the content.
+ *
+ * @note The function terminates the program if inputs are invalid.
+ */
+uint64_t brin_hash64(Brin *b)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    return brin_cached_hash(b);
+}
+
+/**
+ * @brief Returns the seeded 64-bit hash of a span of bytes.
+ *
+ * Different seeds give independent hash functions, e.g. to harden tables
+ * against crafted keys. The result is never cached.
+ *
+ * @param v    The span to hash.
+ * @param seed The seed.
+ * @return The hash of the span.
+ */
+uint64_t brin_hash64_seeded(BrinView v, uint64_t seed)
+{
+    if (!v.data && v.length)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    return brin_hash_bytes(v.data, v.length, seed, 0);
+}
+
+/**
+ * @brief Returns the seeded 64-bit hash of a span, ignoring ASCII case.
+ *
+ * ASCII letters are folded to lowercase as they are loaded, eight bytes at
+ * a time, so no lowercased copy is made. Spans differing only in ASCII case
+ * hash identically; other bytes are hashed as-is.
+ *
+ * @param v    The span to hash.
+ * @param seed The seed.
+ * @return The case-insensitive hash of the span.
+ */
+uint64_t brin_hash64_ci(BrinView v, uint64_t seed)
+{
+    if (!v.data && v.length)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    return brin_hash_bytes(v.data, v.length, seed, 1);
+}
+
+/**
+ * @brief Creates an empty intern table.
+ *
+ * @return An intern table holding no strings.
+ *
+ * @note The function exits the program if memory allocation fails.
+ */
+BrinInternTable brin_intern_table_new(void)
+{
+    BrinInternTable t;
+    t.capacity = 64;
+    t.count = 0;
+    t.hashes = calloc(t.capacity, sizeof(*t.hashes));
+    t.entries = calloc(t.capacity, sizeof(*t.entries));
+    if (!t.hashes || !t.entries)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return t;
+}
+
+/**
+ * @brief Frees an intern table and every canonical Brin it holds.
+ *
+ * All handles returned by brin_intern() on this table become invalid.
+ *
+ * @param t Pointer to the intern table to destroy.
+ */
+void brin_intern_table_destroy(BrinInternTable *t)
+{
+    if (!t) return;
+    for (size_t i = 0; i < t->capacity; ++i) free(t->entries[i]);
+    free(t->hashes);
+    free(t->entries);
+    t->hashes = NULL;
+    t->entries = NULL;
+    t->capacity = 0;
+    t->count = 0;
+}
+
+/* Doubles the slot array of `t` and reinserts the canonical entries. */
+static void brin_intern_table_grow(BrinInternTable *t)
+{
+    size_t capacity = t->capacity * 2;
+    uint64_t *hashes = calloc(capacity, sizeof(*hashes));
+    Brin **entries = calloc(capacity, sizeof(*entries));
+    if (!hashes || !entries)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < t->capacity; ++i)
+    {
+        if (!t->entries[i]) continue;
+        size_t slot = (size_t)t->hashes[i] & (capacity - 1);
+        while (entries[slot]) slot = (slot + 1) & (capacity - 1);
+        hashes[slot] = t->hashes[i];
+        entries[slot] = t->entries[i];
+    }
+    free(t->hashes);
+    free(t->entries);
+    t->hashes = hashes;
+    t->entries = entries;
+    t->capacity = capacity;
+}
+
+/**
+ * @brief Returns the canonical Brin holding the bytes of `v`.
+ *
+ * The first time some bytes are seen, a canonical immutable Brin is created
+ * with its struct and bytes in one allocation; later calls with equal bytes
+ * return the same pointer without allocating. Two handles from the same
+ * table are therefore equal exactly when the pointers are equal.
+ *
+ * @param t Pointer to the intern table.
+ * @param v The bytes to intern; they are copied only on first insertion.
+ * @return The canonical Brin, owned by the table until it is destroyed.
+ *
+ * @note The returned Brin must not be modified nor destroyed.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+const Brin *brin_intern(BrinInternTable *t, BrinView v)
+{
+    if (!t || !t->entries || (!v.data && v.length))
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    uint64_t hash = brin_hash_bytes(v.data, v.length, 0, 0);
+    size_t mask = t->capacity - 1;
+    size_t slot = (size_t)hash & mask;
+    while (t->entries[slot])
+    {
+        Brin *e = t->entries[slot];
+        if (t->hashes[slot] == hash && e->length == v.length &&
+                memcmp(e->string, v.data, v.length) == 0)
+            return e;
+        slot = (slot + 1) & mask;
+    }
+
+    Brin *e = malloc(sizeof(Brin) + v.length + 1);
+    if (!e)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    e->string = (char *)(e + 1);
+    memcpy(e->string, v.data, v.length);
+    e->string[v.length] = '\0';
+    e->length = v.length;
+    e->capacity = v.length + 1;
+    e->hash = hash;
+    e->shared = NULL;
+    e->cord = NULL;
+    brin_bind_methods(e);
+    t->hashes[slot] = hash;
+    t->entries[slot] = e;
+    t->count++;
+    if (t->count * 4 >= t->capacity * 3) brin_intern_table_grow(t);
+    return e;
+}
+
+/* Allocates the slot arrays of `m` for `capacity` slots, all empty. */
+static void brin_map_alloc(BrinMap *m, size_t capacity)
+{
+    m->ctrl = malloc(capacity);
+    m->hashes = malloc(capacity * sizeof(*m->hashes));
+    m->keys = malloc(capacity * sizeof(*m->keys));
+    m->key_lengths = malloc(capacity * sizeof(*m->key_lengths));
+    m->values = malloc(capacity * sizeof(*m->values));
+    if (!m->ctrl || !m->hashes || !m->keys || !m->key_lengths || !m->values)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(m->ctrl, BRIN_MAP_EMPTY, capacity);
+    m->capacity = capacity;
+    m->growth_left = capacity - capacity / 8;
+}
+
+/**
+ * @brief Creates an empty BrinMap.
+ *
+ * @return A map holding no entries.
+ *
+ * @note The function exits the program if memory allocation fails.
+ */
+BrinMap brin_map_new(void)
+{
+    BrinMap m;
+    brin_map_alloc(&m, BRIN_MAP_GROUP);
+    m.count = 0;
+    return m;
+}
+
+/**
+ * @brief Frees a BrinMap and its copies of the keys.
+ *
+ * Values are not freed; they belong to the caller.
+ *
+ * @param m Pointer to the map to destroy.
+ */
+void brin_map_destroy(BrinMap *m)
+{
+    if (!m || !m->ctrl) return;
+    for (size_t i = 0; i < m->capacity; ++i)
+    {
+        if (!(m->ctrl[i] & 0x80)) free(m->keys[i]);
+    }
+    free(m->ctrl);
+    free(m->hashes);
+    free(m->keys);
+    free(m->key_lengths);
+    free(m->values);
+    m->ctrl = NULL;
+    m->hashes = NULL;
+    m->keys = NULL;
+    m->key_lengths = NULL;
+    m->values = NULL;
+    m->capacity = 0;
+    m->count = 0;
+    m->growth_left = 0;
+}
+
+/* Bitmask of the slots in the group at `ctrl` whose control byte is `byte`. */
+static unsigned brin_map_match(const uint8_t *ctrl, uint8_t byte)
+{
+#if defined(__SSE2__)
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    __m128i wanted = _mm_set1_epi8((char)byte);
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(group, wanted));
+#else
+    unsigned mask = 0;
+    for (unsigned i = 0; i < BRIN_MAP_GROUP; ++i)
+    {
+        if (ctrl[i] == byte) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+/* Bitmask of the empty or deleted slots in the group at `ctrl`. */
+static unsigned brin_map_match_free(const uint8_t *ctrl)
+{
+#if defined(__SSE2__)
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    return (unsigned)_mm_movemask_epi8(group);
+#else
+    unsigned mask = 0;
+    for (unsigned i = 0; i < BRIN_MAP_GROUP; ++i)
+    {
+        if (ctrl[i] & 0x80) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+/*
+ * Returns the slot holding `key`, or capacity if absent. Groups are visited
+ * in triangular order, which covers every group of a power-of-two table.
+ */
+static size_t brin_map_find(const BrinMap *m, BrinView key, uint64_t hash)
+{
+    size_t groups_mask = m->capacity / BRIN_MAP_GROUP - 1;
+    size_t group = (size_t)(hash >> 7) & groups_mask;
+    uint8_t h2 = (uint8_t)(hash & 0x7F);
+    for (size_t step = 1; ; ++step)
+    {
+        const uint8_t *ctrl = m->ctrl + group * BRIN_MAP_GROUP;
+        unsigned mask = brin_map_match(ctrl, h2);
+        while (mask)
+        {
+            size_t slot = group * BRIN_MAP_GROUP + brin_lowest_bit(mask);
+            if (m->hashes[slot] == hash && m->key_lengths[slot] == key.length &&
+                    memcmp(m->keys[slot], key.data, key.length) == 0)
+                return slot;
+            mask &= mask - 1;
+        }
+        if (brin_map_match(ctrl, BRIN_MAP_EMPTY)) return m->capacity;
+        group = (group + step) & groups_mask;
+    }
+}
+
+/* Returns the first empty or deleted slot on the probe sequence of `hash`. */
+static size_t brin_map_find_free(const BrinMap *m, uint64_t hash)
+{
+    size_t groups_mask = m->capacity / BRIN_MAP_GROUP - 1;
+    size_t group = (size_t)(hash >> 7) & groups_mask;
+    for (size_t step = 1; ; ++step)
+    {
+        unsigned mask = brin_map_match_free(m->ctrl + group * BRIN_MAP_GROUP);
+        if (mask) return group * BRIN_MAP_GROUP + brin_lowest_bit(mask);
+        group = (group + step) & groups_mask;
+    }
+}
+
+/*
+ * Rebuilds the slots of `m` using the stored hashes, dropping deleted
+ * markers. The capacity doubles unless most slots were only tombstones.
+ */
+static void brin_map_grow(BrinMap *m)
+{
+    BrinMap old = *m;
+    int crowded = old.count >= old.capacity / 16 * 7;
+    brin_map_alloc(m, crowded ? old.capacity * 2 : old.capacity);
+    for (size_t i = 0; i < old.capacity; ++i)
+    {
+        if (old.ctrl[i] & 0x80) continue;
+        size_t slot = brin_map_find_free(m, old.hashes[i]);
+        m->ctrl[slot] = old.ctrl[i];
+        m->hashes[slot] = old.hashes[i];
+        m->keys[slot] = old.keys[i];
+        m->key_lengths[slot] = old.key_lengths[i];
+        m->values[slot] = old.values[i];
+        m->growth_left--;
+    }
+    free(old.ctrl);
+    free(old.hashes);
+    free(old.keys);
+    free(old.key_lengths);
+    free(old.values);
+}
+
+static void brin_map_put_hashed(BrinMap *m, BrinView key, uint64_t hash,
+                                void *value)
+{
+    size_t slot = brin_map_find(m, key, hash);
+    if (slot != m->capacity)
+    {
+        m->values[slot] = value;
+        return;
+    }
+    slot = brin_map_find_free(m, hash);
+    if (m->growth_left == 0 && m->ctrl[slot] == BRIN_MAP_EMPTY)
+    {
+        brin_map_grow(m);
+        slot = brin_map_find_free(m, hash);
+    }
+    char *copy = malloc(key.length + 1);
+    if (!copy)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, key.data, key.length);
+    copy[key.length] = '\0';
+    if (m->ctrl[slot] == BRIN_MAP_EMPTY) m->growth_left--;
+    m->ctrl[slot] = (uint8_t)(hash & 0x7F);
+    m->hashes[slot] = hash;
+    m->keys[slot] = copy;
+    m->key_lengths[slot] = key.length;
+    m->values[slot] = value;
+    m->count++;
+}
+
+static void brin_map_check(const BrinMap *m, BrinView key)
+{
+    if (!m || !m->ctrl || (!key.data && key.length))
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Associates `value` with `key`, replacing any previous value.
+ *
+ * The key bytes are copied when a new entry is created.
+ *
+ * @param m     Pointer to the map.
+ * @param key   The key bytes.
+ * @param value The value to store (may be NULL).
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+void brin_map_put(BrinMap *m, BrinView key, void *value)
+{
+    brin_map_check(m, key);
+    brin_map_put_hashed(m, key, brin_hash_bytes(key.data, key.length, 0, 0),
+                        value);
+}
+
+/**
+ * @brief Associates `value` with the content of a Brin key.
+ *
+ * Same as brin_map_put(), but reuses the hash cached in `key`.
+ *
+ * @param m     Pointer to the map.
+ * @param key   Pointer to the Brin key; its hash gets cached.
+ * @param value The value to store (may be NULL).
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+void brin_map_put_brin(BrinMap *m, Brin *key, void *value)
+{
+    BrinView v = brin_view(key);
+    brin_map_check(m, v);
+    brin_map_put_hashed(m, v, brin_cached_hash(key), value);
+}
+
+/**
+ * @brief Looks up the value associated with `key`, without allocating.
+ *
+ * @param m   Pointer to the map.
+ * @param key The key bytes.
+ * @return A pointer to the stored value, valid until the next insertion or
+ *         removal, or NULL if `key` is absent.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+void **brin_map_get(BrinMap *m, BrinView key)
+{
+    brin_map_check(m, key);
+    size_t slot = brin_map_find(m, key,
+                                brin_hash_bytes(key.data, key.length, 0, 0));
+    return slot == m->capacity ? NULL : &m->values[slot];
+}
+
+/**
+ * @brief Looks up the value associated with the content of a Brin key.
+ *
+ * Same as brin_map_get(), but reuses the hash cached in `key`.
+ *
+ * @param m   Pointer to the map.
+ * @param key Pointer to the Brin key; its hash gets cached.
+ * @return A pointer to the stored value, or NULL if `key` is absent.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+void **brin_map_get_brin(BrinMap *m, Brin *key)
+{
+    BrinView v = brin_view(key);
+    brin_map_check(m, v);
+    size_t slot = brin_map_find(m, v, brin_cached_hash(key));
+    return slot == m->capacity ? NULL : &m->values[slot];
+}
+
+/**
+ * @brief Removes the entry associated with `key`, if any.
+ *
+ * @param m   Pointer to the map.
+ * @param key The key bytes.
+ * @return 1 if an entry was removed, 0 if `key` was absent.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+int brin_map_remove(BrinMap *m, BrinView key)
+{
+    brin_map_check(m, key);
+    size_t slot = brin_map_find(m, key,
+                                brin_hash_bytes(key.data, key.length, 0, 0));
+    if (slot == m->capacity) return 0;
+    free(m->keys[slot]);
+    const uint8_t *group = m->ctrl + slot / BRIN_MAP_GROUP * BRIN_MAP_GROUP;
+    if (brin_map_match(group, BRIN_MAP_EMPTY))
+    {
+        m->ctrl[slot] = BRIN_MAP_EMPTY;
+        m->growth_left++;
+    }
+    else
+    {
+        m->ctrl[slot] = BRIN_MAP_DELETED;
+    }
+    m->count--;
+    return 1;
+}
+
+/**
+ * @brief Iterates over the entries of a map, in unspecified order.
+ *
+ * Start with `*cursor` set to 0 and call repeatedly until it returns 0.
+ * The map must not be modified during the iteration.
+ *
+ * @param m      Pointer to the map.
+ * @param cursor Pointer to the iteration state.
+ * @param key    If not NULL, receives a view of the entry's key.
+ * @param value  If not NULL, receives the entry's value.
+ * @return 1 if an entry was produced, 0 when the iteration is over.
+ */
+int brin_map_next(const BrinMap *m, size_t *cursor, BrinView *key,
+                  void **value)
+{
+    if (!m || !cursor)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    while (*cursor < m->capacity)
+    {
+        size_t slot = (*cursor)++;
+        if (m->ctrl[slot] & 0x80) continue;
+        if (key) *key = brin_view_n(m->keys[slot], m->key_lengths[slot]);
+        if (value) *value = m->values[slot];
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Returns a new Brin sharing the buffer of `b` instead of copying it.
+ *
+ * Both Brins reference the same bytes through a reference count. Reading
+ * functions work on the shared bytes directly; the first mutating function
+ * called on either Brin gives it a private copy, leaving the other intact.
+ * Each share must be released with brin_destroy(); the buffer is freed
+ * with the last one.
+ *
+ * The reference count is atomic, so shares may be handed to other threads
+ * and used or destroyed there, as long as each Brin struct itself is only
+ * used by one thread at a time. Build with BRIN_NO_ATOMICS for
+ * single-threaded programs.
+ *
+ * @param b Pointer to the Brin to share.
+ * @return A Brin with the same content, sharing its buffer.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+Brin brin_share(Brin *b)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_share_buffer(b);
+    return *b;
+}
+
+/**
+ * @brief Checks if the buffer of a Brin is shared with other Brins.
+ *
+ * @param b Pointer to the Brin instance.
+ * @return 1 if a mutation would copy the buffer first, 0 otherwise.
+ *
+ * @note The function terminates the program if inputs are invalid.
+ */
+int brin_is_shared(Brin *b)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    return b->shared && brin_ref_count(&b->shared->refs) > 1;
+}
+
+/**
+ * @brief Returns a Brin viewing `length` bytes of `b` from `start`, without copying.
+ *
+ * The substring shares the reference-counted buffer of `b` (see
+ * brin_share()), so the parent's bytes stay alive until both are destroyed.
+ * Its `string` points inside the parent buffer and is generally not
+ * null-terminated: use brin_cstr() when a C string is needed. The first
+ * mutation, or the first call needing a terminator, gives it a private
+ * copy of just its own bytes.
+ *
+ * @param b      Pointer to the parent Brin.
+ * @param start  Index of the first byte of the substring.
+ * @param length Number of bytes in the substring.
+ * @return A Brin sharing the parent's buffer.
+ *
+ * @note The function exits the program if inputs are invalid, if the range
+ *       is out of bounds, or if memory allocation fails.
+ */
+Brin brin_substr_shared(Brin *b, size_t start, size_t length)
+{
+    if (!b || !b->string || start > b->length || length > b->length - start)
+    {
+        fprintf(stderr, "Error: invalid input\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_share_buffer(b);
+    Brin sub = *b;
+    sub.string = b->string + start;
+    sub.length = length;
+    sub.hash = 0;
+    return sub;
+}
+
+/**
+ * @brief Returns the content of a Brin as a null-terminated C string.
+ *
+ * For shared substrings that do not end where their parent does, this
+ * first gives the Brin a private null-terminated copy of its bytes.
+ * Every other Brin is returned as is.
+ *
+ * @param b Pointer to the Brin instance.
+ * @return `b->string`, guaranteed to be null-terminated.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+const char *brin_cstr(Brin *b)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_terminate(b);
+    return b->string;
+}
+
+/* Appends one piece to the cord of `b`, creating the cord if needed. */
+static void brin_cord_push(Brin *b, struct BrinPiece piece)
+{
+    struct BrinCord *cord = b->cord;
+    if (!cord)
+    {
+        cord = calloc(1, sizeof(*cord));
+        if (!cord)
+        {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        b->cord = cord;
+    }
+    if (cord->count == cord->capacity)
+    {
+        size_t capacity = cord->capacity ? cord->capacity * 2 : 8;
+        struct BrinPiece *pieces = realloc(cord->pieces,
+                                           capacity * sizeof(*pieces));
+        if (!pieces)
+        {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        cord->pieces = pieces;
+        cord->capacity = capacity;
+    }
+    cord->pieces[cord->count++] = piece;
+    cord->length += piece.length;
+    b->length += piece.length;
+    b->hash = 0;
+}
+
+/**
+ * @brief Appends a view to a Brin lazily, without copying its bytes.
+ *
+ * The view is recorded as a pending piece in O(1); the bytes are copied
+ * only when the Brin is flattened, which happens in brin_cstr() and in any
+ * other function that reads or modifies the content. brin_write() outputs
+ * pending pieces without flattening. `b->length` already includes the
+ * pending pieces, but `b->string` only holds the flattened prefix.
+ *
+ * @param[in,out] b Pointer to the Brin instance.
+ * @param[in] piece Bytes to append; they must stay valid and unchanged
+ *                  until the Brin is flattened or destroyed. A view of
+ *                  `b`'s own content is allowed.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+void brin_concat_lazy(Brin *b, BrinView piece)
+{
+    if (!b || !b->string || (!piece.data && piece.length))
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    if (piece.length == 0) return;
+    struct BrinPiece p = { piece.data, 0, piece.length, NULL, NULL };
+    size_t prefix = b->length - (b->cord ? b->cord->length : 0);
+    if (piece.data >= b->string && piece.data < b->string + prefix)
+    {
+        p.data = NULL;
+        p.offset = (size_t)(piece.data - b->string);
+    }
+    brin_cord_push(b, p);
+}
+
+/**
+ * @brief Appends a Brin to another lazily, taking ownership of its buffer.
+ *
+ * Works like brin_concat_lazy(), but the buffer of `piece` is moved into
+ * `b` instead of being borrowed, so the bytes live as long as needed.
+ * Pending pieces of `piece` are moved along. `piece` is left empty, as if
+ * destroyed.
+ *
+ * @param[in,out] b     Pointer to the Brin instance to append to.
+ * @param[in,out] piece Pointer to the Brin to move; must not be `b`.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+void brin_concat_lazy_brin(Brin *b, Brin *piece)
+{
+    if (!b || !b->string || !piece || !piece->string || b == piece)
+    {
+        fprintf(stderr, "Error: invalid input\n");
+        exit(EXIT_FAILURE);
+    }
+    struct BrinCord *tail = piece->cord;
+    size_t prefix = piece->length - (tail ? tail->length : 0);
+    struct BrinPiece head =
+    {
+        piece->string, 0, prefix, piece->string, piece->shared
+    };
+    brin_cord_push(b, head);
+    if (tail)
+    {
+        for (size_t i = 0; i < tail->count; ++i)
+        {
+            /* `head` keeps the buffer that offsets refer to alive. */
+            struct BrinPiece moved = tail->pieces[i];
+            moved.data = brin_piece_data(piece, &moved);
+            brin_cord_push(b, moved);
+        }
+        free(tail->pieces);
+        free(tail);
+    }
+    piece->string = NULL;
+    piece->length = 0;
+    piece->capacity = 0;
+    piece->hash = 0;
+    piece->shared = NULL;
+    piece->cord = NULL;
+}
+
+/*
+ * Writes every byte described by `iov` to `fd`, resuming after partial
+ * writes and signal interruptions. `iov` is consumed in the process.
+ */
+static ssize_t brin_writev_all(int fd, struct iovec *iov, int count)
+{
+    ssize_t total = 0;
+    while (count > 0)
+    {
+        ssize_t n = writev(fd, iov, count);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        total += n;
+        while (count > 0 && (size_t)n >= iov->iov_len)
+        {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Writes the content of a Brin to a file descriptor.
+ *
+ * Pending pieces from brin_concat_lazy() are streamed straight from where
+ * they live with `writev`, without flattening the Brin. Partial writes and
+ * interrupted calls are retried until everything is written.
+ *
+ * @param fd Open file descriptor to write to.
+ * @param b  Pointer to the Brin instance.
+ * @return The number of bytes written (`b->length`), or -1 on error with `errno` set.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+ssize_t brin_write(int fd, Brin *b)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    struct BrinCord *cord = b->cord;
+    struct iovec iov[BRIN_IOV_BATCH];
+    int count = 0;
+    ssize_t total = 0;
+
+    iov[count].iov_base = b->string;
+    iov[count++].iov_len = b->length - (cord ? cord->length : 0);
+    for (size_t i = 0; cord && i < cord->count; ++i)
+    {
+        if (count == BRIN_IOV_BATCH)
+        {
+            ssize_t n = brin_writev_all(fd, iov, count);
+            if (n < 0) return -1;
+            total += n;
+            count = 0;
+        }
+        iov[count].iov_base = (void *)brin_piece_data(b, &cord->pieces[i]);
+        iov[count++].iov_len = cord->pieces[i].length;
+    }
+    ssize_t n = brin_writev_all(fd, iov, count);
+    if (n < 0) return -1;
+    return total + n;
+}
+
+/**
+ * @brief Writes views to a file descriptor, with a separator between them, without joining them.
+ *
+ * The bytes go out exactly as brin_join_n() would lay them out, but no
+ * joined buffer is built: the views and separators are gathered into
+ * batches of `iovec` entries and written with `writev`, resuming after
+ * partial writes and signal interruptions.
+ *
+ * @param fd      File descriptor to write to.
+ * @param pieces  Array of `count` views, e.g. from brin_view() or brin_column_get().
+ * @param count   Number of views.
+ * @param sep     Separator written between views (may be NULL only if `sep_len` is 0).
+ * @param sep_len Length of the separator.
+ * @return The number of bytes written, or -1 on error (with `errno` set).
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+ssize_t brin_writev(int fd, const BrinView *pieces, size_t count,
+                    const char *sep, size_t sep_len)
+{
+    if ((!pieces && count) || (!sep && sep_len))
+    {
+        fprintf(stderr, "Error: invalid input\n");
+        exit(EXIT_FAILURE);
+    }
+    struct iovec iov[BRIN_IOV_BATCH];
+    int used = 0;
+    ssize_t total = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (used + 2 > BRIN_IOV_BATCH)
+        {
+            ssize_t n = brin_writev_all(fd, iov, used);
+            if (n < 0) return -1;
+            total += n;
+            used = 0;
+        }
+        if (i > 0 && sep_len)
+        {
+            iov[used].iov_base = (void *)sep;
+            iov[used++].iov_len = sep_len;
+        }
+        iov[used].iov_base = (void *)pieces[i].data;
+        iov[used++].iov_len = pieces[i].length;
+    }
+    ssize_t n = brin_writev_all(fd, iov, used);
+    if (n < 0) return -1;
+    return total + n;
+}
+
+/**
+ * @brief Creates a Brin taking ownership of a malloc'd buffer, without copying it.
+ *
+ * The buffer becomes the Brin's storage: it is freed by brin_destroy() and
+ * its spare room is used by later appends. When `capacity` leaves no room
+ * for the terminator, the buffer is grown by one byte with `realloc`.
+ *
+ * @param ptr      Buffer allocated with malloc, calloc or realloc.
+ * @param length   Number of content bytes at the start of the buffer.
+ * @param capacity Size of the buffer in bytes (at least `length`).
+ * @return A Brin owning the buffer.
+ *
+ * @note The caller must not use or free `ptr` afterwards.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+Brin brin_adopt(char *ptr, size_t length, size_t capacity)
+{
+    if (!ptr || capacity < length)
+    {
+        fprintf(stderr, "Error: invalid input\n");
+        exit(EXIT_FAILURE);
+    }
+    if (capacity == length)
+    {
+        char *grown = realloc(ptr, length + 1);
+        if (!grown)
+        {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        ptr = grown;
+        capacity = length + 1;
+    }
+    ptr[length] = '\0';
+
+    Brin b;
+    b.string = ptr;
+    b.length = length;
+    b.capacity = capacity;
+    b.hash = 0;
+    b.shared = NULL;
+    b.cord = NULL;
+    brin_bind_methods(&b);
+    return b;
+}
+
+/**
+ * @brief Hands the buffer of a Brin back to the caller, without copying it.
+ *
+ * The returned buffer is null-terminated and must be released with free().
+ * The Brin is left empty, as if destroyed. A buffer still shared with other
+ * Brins, or pending lazy pieces, are copied into a fresh buffer first.
+ *
+ * @param b      Pointer to the Brin instance.
+ * @param length If not NULL, receives the number of content bytes.
+ * @return The malloc'd buffer holding the content.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+char *brin_release(Brin *b, size_t *length)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_make_unique(b);
+    char *buffer = b->string;
+    if (length) *length = b->length;
+    b->string = NULL;
+    b->length = 0;
+    b->capacity = 0;
+    b->hash = 0;
+    brin_destroy(b);
+    return buffer;
+}
+
+/**
+ * @brief Creates an independent copy of a Brin.
+ *
+ * The content is copied with a single exact-size allocation using the
+ * known length, so embedded null bytes are kept and nothing is re-measured.
+ * The cached hash, if any, carries over to the copy.
+ *
+ * @param b Pointer to the Brin instance to copy.
+ * @return A new Brin owning its own copy of the content.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+Brin brin_clone(Brin *b)
+{
+    if (!b || !b->string)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_flatten(b);
+    Brin copy = brin_new_n(b->string, b->length);
+    copy.hash = b->hash;
+    return copy;
+}
+
+/**
+ * @brief Transfers the content of `src` to `dst` without copying it.
+ *
+ * Whatever `dst` held is destroyed first; `src` is left empty, as if
+ * destroyed, and may be reused or destroyed again safely.
+ *
+ * @param[out]    dst Pointer to the destination, a Brin instance or a destroyed one.
+ * @param[in,out] src Pointer to the Brin instance to move from.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+void brin_move(Brin *dst, Brin *src)
+{
+    if (!dst || !src)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    if (dst == src) return;
+    if (dst->string) brin_destroy(dst);
+    *dst = *src;
+    src->string = NULL;
+    src->length = 0;
+    src->capacity = 0;
+    src->hash = 0;
+    src->shared = NULL;
+    src->cord = NULL;
+}
+
+/**
+ * @brief Exchanges the contents of two Brin instances without copying them.
+ *
+ * @param[in,out] a Pointer to the first Brin instance.
+ * @param[in,out] b Pointer to the second Brin instance.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+void brin_swap(Brin *a, Brin *b)
+{
+    if (!a || !b)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+    Brin tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+/**
+ * @brief Creates an empty column.
+ *
+ * @return A column holding no fields.
+ *
+ * @note The function exits the program if memory allocation fails.
+ */
+BrinColumn brin_column_new(void)
+{
+    BrinColumn c;
+    c.bytes_capacity = 64;
+    c.offsets_capacity = 16;
+    c.count = 0;
+    c.bytes = malloc(c.bytes_capacity);
+    c.offsets = malloc(c.offsets_capacity * sizeof(*c.offsets));
+    if (!c.bytes || !c.offsets)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    c.offsets[0] = 0;
+    return c;
+}
+
+/**
+ * @brief Frees the byte pool and offset table of a column.
+ *
+ * @param c Pointer to the column to destroy.
+ */
+void brin_column_destroy(BrinColumn *c)
+{
+    if (!c) return;
+    free(c->bytes);
+    free(c->offsets);
+    c->bytes = NULL;
+    c->offsets = NULL;
+    c->count = 0;
+    c->bytes_capacity = 0;
+    c->offsets_capacity = 0;
+}
+
+/* Grows the pool and offset table of `c` to hold `fields` more fields of `bytes` bytes. */
+static void brin_column_reserve(BrinColumn *c, size_t fields, size_t bytes)
+{
+    size_t used = c->offsets[c->count];
+    if (used + bytes > c->bytes_capacity)
+    {
+        size_t capacity = c->bytes_capacity * 2;
+        if (capacity < used + bytes) capacity = used + bytes;
+        char *pool = realloc(c->bytes, capacity);
+        if (!pool)
+        {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        c->bytes = pool;
+        c->bytes_capacity = capacity;
+    }
+    if (c->count + 1 + fields > c->offsets_capacity)
+    {
+        size_t capacity = c->offsets_capacity * 2;
+        if (capacity < c->count + 1 + fields) capacity = c->count + 1 + fields;
+        size_t *offsets = realloc(c->offsets, capacity * sizeof(*offsets));
+        if (!offsets)
+        {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        c->offsets = offsets;
+        c->offsets_capacity = capacity;
+    }
+}
+
+/**
+ * @brief Appends a copy of the bytes of `v` as the last field of a column.
+ *
+ * @param c Pointer to the column.
+ * @param v The bytes to append.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+void brin_column_push(BrinColumn *c, BrinView v)
+{
+    if (!c || !c->offsets || (!v.data && v.length))
+    {
+        fprintf(stderr, "Error: invalid input\n");
+        exit(EXIT_FAILURE);
+    }
+    brin_column_reserve(c, 1, v.length);
+    size_t end = c->offsets[c->count];
+    if (v.length) memcpy(c->bytes + end, v.data, v.length);
+    c->offsets[++c->count] = end + v.length;
+}
+
+/**
+ * @brief Returns a view over field `i` of a column.
+ *
+ * The view points into the byte pool and stays valid until the column is
+ * modified or destroyed.
+ *
+ * @param c Pointer to the column.
+ * @param i Index of the field.
+ * @return A BrinView over the field.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+BrinView brin_column_get(const BrinColumn *c, size_t i)
+{
+    if (!c || i >= c->count)
+    {
+        fprintf(stderr, "Error: invalid input\n");
+        exit(EXIT_FAILURE);
+    }
+    return brin_view_n(c->bytes + c->offsets[i],
+                       c->offsets[i + 1] - c->offsets[i]);
+}
+
+/**
+ * @brief Splits the content of a Brin into a column.
+ *
+ * Tokens follow the same rules as brin_split(): every byte of `sep` is a
+ * delimiter, runs of delimiters are collapsed and empty tokens are skipped.
+ * Instead of one allocation per token, all tokens are copied into a single
+ * byte pool, sized exactly after a counting pass.
+ *
+ * @param b   Pointer to the Brin instance to split.
+ * @param sep The null-terminated set of delimiter bytes.
+ * @return A column holding the tokens, to be freed with brin_column_destroy().
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+BrinColumn brin_split_column(Brin *b, const char *sep)
+{
+    if (!b || !b->string || !sep)
+    {
+        fprintf(stderr, "Error: one of the inputs is null\n");
+        exit(EXIT_FAILURE);
+    }
+
+    struct BrinDelims delims;
+    brin_delimiters(sep, &delims);
+    brin_flatten(b);
+
+    size_t count = 0, bytes = 0;
+    size_t pos = 0, start, len;
+    while (brin_next_token(b->string, b->length, &pos, &delims, &start, &len))
+    {
+        count++;
+        bytes += len;
+    }
+
+    BrinColumn c = brin_column_new();
+    brin_column_reserve(&c, count, bytes);
+    size_t end = 0;
+    pos = 0;
+    while (brin_next_token(b->string, b->length, &pos, &delims, &start, &len))
+    {
+        memcpy(c.bytes + end, b->string + start, len);
+        end += len;
+        c.offsets[++c.count] = end;
+    }
+    return c;
+}
+
+/**
+ * @brief Joins the fields of a column into a new Brin.
  *
- * @param[in,out] b Pointer to the Brin instance to modify.
- * @param[in] suffix Null-terminated string to append.
+ * The result is built in a single allocation of the exact final size.
  *
- * @pre Both `b` and `suffix` must not be NULL, and `b->string` must be valid.
+ * @param c       Pointer to the column.
+ * @param sep     Separator placed between fields (may be NULL only if `sep_len` is 0).
+ * @param sep_len Length of the separator.
+ * @return A Brin holding the joined fields.
  *
- * @note The function will exit the program if any input is NULL
- *       or if memory allocation fails.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
  */
-void brin_concat(Brin *b, const char *suffix)
+Brin brin_column_join(const BrinColumn *c, const char *sep, size_t sep_len)
 {
-    if (!b || !b->string || !suffix)
+    if (!c || !c->offsets || (!sep && sep_len))
     {
-        fprintf(stderr, "Error: one of the input is null\n");
+        fprintf(stderr, "Error: invalid input\n");
         exit(EXIT_FAILURE);
     }
-    size_t suffix_len = strlen(suffix);
-    size_t new_length = b->length + suffix_len;
-    char *new_string = realloc(b->string, new_length + 1);
-    if (!new_string)
+    size_t total = c->offsets[c->count];
+    if (c->count) total += (c->count - 1) * sep_len;
+
+    Brin b = brin_new_n(NULL, 0);
+    char *string = realloc(b.string, total + 1);
+    if (!string)
     {
         fprintf(stderr, "Error: memory allocation failed\n");
         exit(EXIT_FAILURE);
     }
-    b->string = new_string;
-    strcat(b->string, suffix);
-    b->length = new_length;
+    b.string = string;
+    for (size_t i = 0; i < c->count; ++i)
+    {
+        size_t len = c->offsets[i + 1] - c->offsets[i];
+        if (len) memcpy(string, c->bytes + c->offsets[i], len);
+        string += len;
+        if (i + 1 < c->count && sep_len)
+        {
+            memcpy(string, sep, sep_len);
+            string += sep_len;
+        }
+    }
+    *string = '\0';
+    b.length = total;
+    b.capacity = total + 1;
+    return b;
+}
+
+/* Orders views bytewise, a proper prefix sorting first. */
+static int brin_view_compare(const void *a, const void *b)
+{
+    const BrinView *x = a, *y = b;
+    size_t n = x->length < y->length ? x->length : y->length;
+    int r = n ? memcmp(x->data, y->data, n) : 0;
+    if (r) return r;
+    return (x->length > y->length) - (x->length < y->length);
 }
 
 /**
- * @brief Check if the Brin string contains a given substring.
- *
- * This function searches for the first occurrence of the null-terminated
- * string `string` inside the Brin's internal string.
- *
- * @param[in] b Pointer to the Brin instance to check.
- * @param[in] string Null-terminated substring to search for.
+ * @brief Sorts the fields of a column in bytewise lexicographic order.
  *
- * @return 1 if the substring is found, 0 otherwise.
+ * The fields are sorted through a table of views, then copied once into a
+ * new byte pool so that the column stays a sequential scan in sorted order.
  *
- * @pre Both `b` and `string` must not be NULL, and `b->string` must be valid.
+ * @param c Pointer to the column.
  *
- * @note The function will exit the program if any input is NULL.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
  */
-int brin_contains(Brin *b, const char *string)
+void brin_column_sort(BrinColumn *c)
 {
-    if (!b || !b->string || !string)
+    if (!c || !c->offsets)
     {
-        fprintf(stderr, "Error: one of the input is null\n");
+        fprintf(stderr, "Error: invalid input\n");
+        exit(EXIT_FAILURE);
+    }
+    if (c->count < 2) return;
+    BrinView *views = malloc(c->count * sizeof(*views));
+    char *pool = malloc(c->bytes_capacity);
+    if (!views || !pool)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
         exit(EXIT_FAILURE);
     }
-    return strstr(b->string, string) != NULL;
+    for (size_t i = 0; i < c->count; ++i) views[i] = brin_column_get(c, i);
+    qsort(views, c->count, sizeof(*views), brin_view_compare);
+
+    size_t end = 0;
+    for (size_t i = 0; i < c->count; ++i)
+    {
+        if (views[i].length) memcpy(pool + end, views[i].data, views[i].length);
+        end += views[i].length;
+        c->offsets[i + 1] = end;
+    }
+    free(views);
+    free(c->bytes);
+    c->bytes = pool;
 }
 
 /**
- * @brief Compare the Brin string with a null-terminated string for equality.
- *
- * This function checks if the Brin's internal string is exactly equal
- * to the provided null-terminated string `string`.
- *
- * @param[in] b Pointer to the Brin instance.
- * @param[in] string Null-terminated string to compare with.
+ * @brief Computes the 64-bit hash of every field of a column.
  *
- * @return 1 if both strings are equal, 0 otherwise.
+ * With a seed of 0, `out[i]` equals brin_hash64() of a Brin holding the
+ * same bytes as field `i`, so fields can be matched against Brins through
+ * their cached hashes.
  *
- * @pre Neither `b`, `b->string`, nor `string` can be NULL.
+ * @param c    Pointer to the column.
+ * @param seed Seed mixed into every hash.
+ * @param out  Array of at least `c->count` entries receiving the hashes.
  *
- * @note The function terminates the program if any input pointer is NULL.
+ * @note The function exits the program if inputs are invalid.
  */
-int brin_equals(Brin *b, const char *string)
+void brin_column_hashes(const BrinColumn *c, uint64_t seed, uint64_t *out)
 {
-    if (!b || !b->string || !string)
+    if (!c || !c->offsets || (!out && c->count))
     {
-        fprintf(stderr, "Error: one of the inputs is null\n");
+        fprintf(stderr, "Error: invalid input\n");
         exit(EXIT_FAILURE);
     }
-    return strcmp(b->string, string) == 0;
+    for (size_t i = 0; i < c->count; ++i)
+        out[i] = brin_hash_bytes(c->bytes + c->offsets[i],
+                                 c->offsets[i + 1] - c->offsets[i], seed, 0);
 }
 
 /**
- * @brief Finds the first occurrence index of a substring within the Brin string.
- *
- * This function searches for the first occurrence of the null-terminated substring
- * `string` inside the Brin's internal string.
- *
- * @param[in] b Pointer to the Brin instance.
- * @param[in] string Null-terminated substring to search for.
- *
- * @return The zero-based index of the first occurrence of `string` inside `b->string`,
- *         or -1 if the substring is not found.
+ * @brief Creates an empty CSV record set.
  *
- * @pre Neither `b`, `b->string`, nor `string` can be NULL.
+ * @param delimiter Field delimiter, such as `,` or `\t`; it cannot be a
+ *                  quote, a line break or a null byte.
+ * @return A record set holding no records.
  *
- * @note The function terminates the program if any input pointer is NULL.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
  */
-int brin_index_of(Brin *b, const char *string)
+BrinCsv brin_csv_new(char delimiter)
 {
-    if (!b || !b->string || !string)
+    if (delimiter == '"' || delimiter == '\n' || delimiter == '\r'
+        || delimiter == '\0')
     {
-        fprintf(stderr, "Error: one of the input is null\n");
+        fprintf(stderr, "Error: invalid input\n");
         exit(EXIT_FAILURE);
     }
-    char *index = strstr(b->string, string);
-    if (index) return (int)(index - b->string);
-    return -1;
+    BrinCsv csv;
+    csv.fields = brin_column_new();
+    csv.records = 0;
+    csv.records_capacity = 16;
+    csv.record_ends = malloc(csv.records_capacity * sizeof(*csv.record_ends));
+    if (!csv.record_ends)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    csv.delimiter = delimiter;
+    return csv;
 }
 
 /**
- * @brief Inserts a substring into the Brin string at a specified index.
- *
- * This function inserts the null-terminated substring `string` into the Brin's
- * internal string at the zero-based position `index`.
- *
- * @param[in,out] b Pointer to the Brin instance.
- * @param[in] index Position at which to insert the substring (0 ≤ index ≤ b->length).
- * @param[in] string Null-terminated substring to insert.
+ * @brief Frees a CSV record set.
  *
- * @pre Neither `b`, `b->string`, nor `string` can be NULL.
- * @pre `index` must be within the valid range [0, b->length].
+ * @param csv Pointer to the record set to destroy.
+ */
+void brin_csv_destroy(BrinCsv *csv)
+{
+    if (!csv) return;
+    brin_column_destroy(&csv->fields);
+    free(csv->record_ends);
+    csv->record_ends = NULL;
+    csv->records = 0;
+    csv->records_capacity = 0;
+}
+
+/**
+ * @brief Removes every record from a CSV record set, keeping its memory.
  *
- * @note The function will allocate new memory for the combined string, free the
- *       old string, and update the length accordingly.
- * @note The function terminates the program if inputs are invalid or memory allocation fails.
+ * @param csv Pointer to the record set.
  */
-void brin_insert(Brin *b, int index, const char *string)
+void brin_csv_clear(BrinCsv *csv)
+{
+    if (!csv) return;
+    csv->fields.count = 0;
+    csv->records = 0;
+}
+
+/* Returns the index of the lowest set bit of a non-zero mask. */
+static unsigned brin_lowest_bit64(uint64_t mask)
 {
-    if (!b || !b->string || !string)
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctzll(mask);
+#else
+    unsigned i = 0;
+    while (!(mask & 1u))
     {
-        fprintf(stderr, "Error: one of the inputs is null\n");
-        exit(EXIT_FAILURE);
+        mask >>= 1;
+        i++;
     }
-    if (index < 0 || index > (int)b->length)
+    return i;
+#endif
+}
+
+/*
+ * Returns a mask where bit i is the parity of the bits at or below i, that
+ * is, the bytes that lie inside a quoted section given the quote positions.
+ */
+static uint64_t brin_prefix_xor(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+/*
+ * Appends s[start..end) to the fields of `csv`. A field starting with a
+ * quote has its quotes removed and doubled quotes collapsed; bytes after
+ * the closing quote are kept as they are.
+ */
+static void brin_csv_push_field(BrinCsv *csv, const char *s, size_t start,
+                                size_t end)
+{
+    BrinColumn *c = &csv->fields;
+    brin_column_reserve(c, 1, end - start);
+    char *out = c->bytes + c->offsets[c->count];
+    size_t n = 0;
+    if (start < end && s[start] == '"')
     {
-        fprintf(stderr, "Error: invalid index position\n");
-        exit(EXIT_FAILURE);
+        size_t i = start + 1;
+        while (i < end)
+        {
+            if (s[i] != '"')
+            {
+                out[n++] = s[i++];
+                continue;
+            }
+            if (i + 1 < end && s[i + 1] == '"')
+            {
+                out[n++] = '"';
+                i += 2;
+                continue;
+            }
+            i++;
+            while (i < end) out[n++] = s[i++];
+        }
+    }
+    else if (start < end)
+    {
+        memcpy(out, s + start, end - start);
+        n = end - start;
     }
+    c->offsets[c->count + 1] = c->offsets[c->count] + n;
+    c->count++;
+}
 
-    size_t insert_len = strlen(string);
-    size_t new_length = b->length + insert_len;
+/* Marks the fields pushed since the previous record as a complete record. */
+static void brin_csv_end_record(BrinCsv *csv)
+{
+    if (csv->records == csv->records_capacity)
+    {
+        size_t capacity = csv->records_capacity * 2;
+        size_t *ends = realloc(csv->record_ends, capacity * sizeof(*ends));
+        if (!ends)
+        {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        csv->record_ends = ends;
+        csv->records_capacity = capacity;
+    }
+    csv->record_ends[csv->records++] = csv->fields.count;
+}
 
-    char *new_string = malloc(new_length + 1);
-    if (!new_string)
+/*
+ * Where an incremental brin_csv_scan() stands in its input. A block that
+ * was only partly available is scanned again once more bytes arrive, with
+ * its first `done` bytes already handled.
+ */
+struct BrinCsvState
+{
+    size_t block;
+    size_t done;
+    uint64_t carry;
+    size_t field_start;
+    size_t record_start;
+};
+
+/* Returns the number of fields belonging to complete records. */
+static size_t brin_csv_complete_fields(const BrinCsv *csv)
+{
+    return csv->records ? csv->record_ends[csv->records - 1] : 0;
+}
+
+/*
+ * Parses the records of s[0..len) into `csv`, 64 bytes at a time: each
+ * block is classified into quote, delimiter and newline bitmasks, the
+ * prefix XOR of the quote mask tells which bytes are quoted, and only the
+ * unquoted delimiters and newlines are visited to cut fields.
+ *
+ * Scanning resumes from `state`, so s[0..len) may have grown since the
+ * previous call and only the new bytes are looked at. Without `final`, the
+ * fields of a trailing record not yet ended by a newline stay after the
+ * last record of `csv`. Returns 0 if `final` is set and the input ends
+ * inside a quoted field, 1 otherwise.
+ */
+static int brin_csv_scan(BrinCsv *csv, const char *s, size_t len, int final,
+                         struct BrinCsvState *state)
+{
+    const struct BrinKernels *kernels = brin_kernels();
+    unsigned char delimiter = (unsigned char)csv->delimiter;
+    uint64_t quoted_end = state->carry;
+    size_t base = state->block;
+    while (base < len)
     {
-        fprintf(stderr, "Error: memory allocation failed\n");
-        exit(EXIT_FAILURE);
+        const unsigned char *block = (const unsigned char *)s + base;
+        unsigned char tail[64];
+        size_t n = len - base < 64 ? len - base : 64;
+        if (n < 64)
+        {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, block, n);
+            block = tail;
+        }
+        uint64_t valid = n < 64 ? ((uint64_t)1 << n) - 1 : ~(uint64_t)0;
+        uint64_t quotes, delimiters, newlines;
+        kernels->csv_masks(block, delimiter, &quotes, &delimiters, &newlines);
+        uint64_t quoted = brin_prefix_xor(quotes & valid) ^ state->carry;
+        quoted_end = (uint64_t)0 - (quoted >> 63);
+        uint64_t structural = (delimiters | newlines) & valid & ~quoted;
+        structural &= ~(((uint64_t)1 << state->done) - 1);
+        while (structural)
+        {
+            unsigned bit = brin_lowest_bit64(structural);
+            structural &= structural - 1;
+            size_t pos = base + bit;
+            if (newlines >> bit & 1)
+            {
+                size_t end = pos;
+                if (end > state->field_start && s[end - 1] == '\r') end--;
+                brin_csv_push_field(csv, s, state->field_start, end);
+                brin_csv_end_record(csv);
+                state->record_start = pos + 1;
+            }
+            else
+            {
+                brin_csv_push_field(csv, s, state->field_start, pos);
+            }
+            state->field_start = pos + 1;
+        }
+        if (n < 64)
+        {
+            state->done = n;
+            break;
+        }
+        state->carry = quoted_end;
+        state->done = 0;
+        base += 64;
     }
+    state->block = base;
 
-    memcpy(new_string, b->string, index);
-    memcpy(new_string + index, string, insert_len);
-    memcpy(new_string + index + insert_len, b->string + index,
-           b->length - index);
-    new_string[new_length] = '\0';
+    if (!final) return 1;
+    if (state->record_start < len
+            || csv->fields.count > brin_csv_complete_fields(csv))
+    {
+        size_t end = len;
+        if (!quoted_end && end > state->field_start && s[end - 1] == '\r')
+            end--;
+        brin_csv_push_field(csv, s, state->field_start, end);
+        brin_csv_end_record(csv);
+    }
+    return quoted_end == 0;
+}
 
-    free(b->string);
-    b->string = new_string;
-    b->length = new_length;
+/*
+ * Drops the records of `csv`, moving the fields of the unfinished record
+ * that follows them to the front.
+ */
+static void brin_csv_drop_records(BrinCsv *csv)
+{
+    BrinColumn *c = &csv->fields;
+    size_t first = brin_csv_complete_fields(csv);
+    size_t keep = c->count - first;
+    size_t from = c->offsets[first];
+    if (keep)
+    {
+        memmove(c->bytes, c->bytes + from, c->offsets[c->count] - from);
+        for (size_t i = 0; i <= keep; ++i)
+            c->offsets[i] = c->offsets[first + i] - from;
+    }
+    c->count = keep;
+    csv->records = 0;
 }
 
 /**
- * @brief Checks if the Brin string is empty.
+ * @brief Parses CSV text and appends its records to a record set.
  *
- * Returns 1 if the string length is zero, otherwise returns 0.
+ * Fields are separated by the delimiter of `csv` and records by `\n` or
+ * `\r\n`. A field may be enclosed in double quotes, in which case it can
+ * contain delimiters, line breaks and doubled quotes (`""`) standing for
+ * one quote. A final line break is optional. A stray quote inside an
+ * unquoted field still toggles quoting, and that field is kept as it is.
  *
- * @param[in] b Pointer to the Brin instance.
+ * The input is classified 64 bytes at a time with SIMD comparisons (SSE2
+ * or AVX2, see brin_cpu_features()), and quoted regions are found with a prefix XOR over the
+ * quote bitmask, so only field boundaries are visited one by one.
  *
- * @return 1 if the string is empty, 0 otherwise.
+ * @param csv   Pointer to the record set receiving the records.
+ * @param input The CSV text.
+ * @return 1 on success, 0 if the input ends inside a quoted field (the
+ *         last field then holds everything after its opening quote).
  *
- * @pre Neither `b` nor `b->string` can be NULL.
- * @note The function terminates the program if inputs are invalid.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
  */
-int brin_is_empty(Brin *b)
+int brin_csv_parse(BrinCsv *csv, BrinView input)
 {
-    if (!b || !b->string)
+    if (!csv || !csv->record_ends || (!input.data && input.length))
     {
-        fprintf(stderr, "Error: one of the inputs is null\n");
+        fprintf(stderr, "Error: invalid input\n");
         exit(EXIT_FAILURE);
     }
-    return b->length == 0;
+    struct BrinCsvState state = { 0, 0, 0, 0, 0 };
+    return brin_csv_scan(csv, input.data, input.length, 1, &state);
 }
 
 /**
- * @brief Checks if the Brin string consists only of whitespace characters.
- *
- * Returns 1 if all characters in the string are whitespace according to
- * the standard C `isspace` function, otherwise returns 0.
+ * @brief Returns the number of fields in a record.
  *
- * @param[in] b Pointer to the Brin instance.
- *
- * @return 1 if the string is non-empty and contains only whitespace characters,
- *         0 otherwise.
+ * @param csv    Pointer to the record set.
+ * @param record Index of the record.
+ * @return The number of fields of the record.
  *
- * @pre Neither `b` nor `b->string` can be NULL.
- * @note The function terminates the program if inputs are invalid.
+ * @note The function exits the program if inputs are invalid.
  */
-int brin_is_whitespace(Brin *b)
+size_t brin_csv_field_count(const BrinCsv *csv, size_t record)
 {
-    if (!b || !b->string)
+    if (!csv || record >= csv->records)
     {
-        fprintf(stderr, "Error: one of the inputs is null\n");
+        fprintf(stderr, "Error: invalid input\n");
         exit(EXIT_FAILURE);
     }
-    if (b->length == 0) return 0;
-    for (size_t i = 0; i < b->length; ++i)
-    {
-        if (!isspace((unsigned char)b->string[i])) return 0;
-    }
-    return 1;
+    size_t first = record ? csv->record_ends[record - 1] : 0;
+    return csv->record_ends[record] - first;
 }
 
 /**
- * @brief Converts all characters in the Brin string to lowercase.
- *
- * Modifies the string in-place, converting each character to its lowercase
- * equivalent using the standard C `tolower` function.
+ * @brief Returns a view over one field of a record.
  *
- * @param[in,out] b Pointer to the Brin instance.
+ * @param csv    Pointer to the record set.
+ * @param record Index of the record.
+ * @param field  Index of the field within the record.
+ * @return A BrinView over the unescaped field, valid until the record set
+ *         is modified or destroyed.
  *
- * @pre Neither `b` nor `b->string` can be NULL.
- * @note The function terminates the program if inputs are invalid.
+ * @note The function exits the program if inputs are invalid.
  */
-void brin_to_lower(Brin *b)
+BrinView brin_csv_field(const BrinCsv *csv, size_t record, size_t field)
 {
-    if (!b || !b->string)
+    if (field >= brin_csv_field_count(csv, record))
     {
-        fprintf(stderr, "Error: one of the inputs is null\n");
+        fprintf(stderr, "Error: invalid input\n");
         exit(EXIT_FAILURE);
     }
-    for (size_t i = 0; i < b->length; ++i)
-    {
-        b->string[i] = tolower((unsigned char)b->string[i]);
-    }
+    size_t first = record ? csv->record_ends[record - 1] : 0;
+    return brin_column_get(&csv->fields, first + field);
 }
 
 /**
- * @brief Converts all characters in the Brin string to uppercase.
+ * @brief Parses CSV records from a file descriptor in bounded memory.
  *
- * Modifies the string in-place, converting each character to its uppercase
- * equivalent using the standard C `toupper` function.
+ * Reads up to `block_size` bytes at a time into one reusable buffer and
+ * parses every complete record in it, with the same rules as
+ * brin_csv_parse(). The records of each block are handed to `on_records`
+ * as a record set that is cleared afterwards; a record spanning a block
+ * boundary is kept in the buffer and delivered once its end has been read.
+ * Memory use stays proportional to the block size plus the longest record,
+ * whatever the size of the input, and each byte is scanned once however
+ * short the reads are.
  *
- * @param[in,out] b Pointer to the Brin instance.
+ * @param fd         File descriptor to read until end of file.
+ * @param delimiter  Field delimiter, as for brin_csv_new().
+ * @param block_size Number of bytes to read at a time, or 0 for 64 KiB.
+ * @param on_records Called with each batch of records; returns non-zero to
+ *                   go on reading, 0 to stop early.
+ * @param ctx        Passed unchanged to `on_records`.
+ * @return 1 once the input is parsed or `on_records` stops the stream, 0 if
+ *         the input ends inside a quoted field (its last record is still
+ *         delivered), -1 on a read error (with `errno` set).
  *
- * @pre Neither `b` nor `b->string` can be NULL.
- * @note The function terminates the program if inputs are invalid.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
  */
-void brin_to_upper(Brin *b)
+int brin_csv_stream(int fd, char delimiter, size_t block_size,
+                    int (*on_records)(const BrinCsv *csv, void *ctx),
+                    void *ctx)
 {
-    if (!b || !b->string)
+    if (fd < 0 || !on_records)
     {
-        fprintf(stderr, "Error: one of the inputs is null\n");
+        fprintf(stderr, "Error: invalid input\n");
         exit(EXIT_FAILURE);
     }
-    for (size_t i = 0; i < b->length; ++i)
+    if (block_size == 0) block_size = BRIN_CSV_BLOCK;
+
+    BrinCsv csv = brin_csv_new(delimiter);
+    Brin buffer = brin_new_n(NULL, 0);
+    struct BrinCsvState state = { 0, 0, 0, 0, 0 };
+    int status = 1;
+    for (;;)
     {
-        b->string[i] = toupper((unsigned char)b->string[i]);
+        brin_reserve(&buffer, buffer.length + block_size + 1);
+        size_t room = buffer.capacity - buffer.length - 1;
+        ssize_t n = read(fd, buffer.string + buffer.length, room);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0)
+        {
+            status = -1;
+            break;
+        }
+
+        if (n == 0)
+        {
+            status = brin_csv_scan(&csv, buffer.string, buffer.length, 1,
+                                   &state);
+            if (csv.records) on_records(&csv, ctx);
+            break;
+        }
+        buffer.length += (size_t)n;
+        brin_csv_scan(&csv, buffer.string, buffer.length, 0, &state);
+        if (csv.records)
+        {
+            /* The fields of the unfinished record are hidden meanwhile. */
+            size_t pending = csv.fields.count;
+            csv.fields.count = brin_csv_complete_fields(&csv);
+            int more = on_records(&csv, ctx);
+            csv.fields.count = pending;
+            if (!more) break;
+            brin_csv_drop_records(&csv);
+        }
+
+        /* Keep the current field and the partly scanned block only. */
+        size_t consumed = state.field_start < state.block
+                          ? state.field_start : state.block;
+        memmove(buffer.string, buffer.string + consumed,
+                buffer.length - consumed);
+        buffer.length -= consumed;
+        state.block -= consumed;
+        state.field_start -= consumed;
+        state.record_start = state.record_start > consumed
+                             ? state.record_start - consumed : 0;
     }
+    int saved = errno;
+    brin_destroy(&buffer);
+    brin_csv_destroy(&csv);
+    errno = saved;
+    return status;
 }
 
 /**
- * @brief Removes leading whitespace characters from the Brin string.
+ * @brief Reads the next line of a stream into a Brin, reusing its buffer.
  *
- * Moves the start pointer past any whitespace characters and shifts the
- * remaining string to the beginning. Then reallocates memory to shrink
- * the buffer to the new trimmed length.
+ * The line replaces the content of `b`, without its trailing `\n`. The
+ * existing allocation of `b` is handed to `getline`, so reading many lines
+ * into the same Brin allocates only when a line is longer than any before.
+ * Null bytes inside the line are kept.
  *
- * @param[in,out] b Pointer to the Brin instance.
+ * @param b      Pointer to the Brin instance receiving the line.
+ * @param stream The stream to read from.
+ * @return The number of bytes consumed from the stream, newline included,
+ *         0 at end of file, or -1 on a read error (`b` is then empty).
  *
- * @pre Neither `b` nor `b->string` can be NULL.
- * @note The function terminates the program if inputs are invalid or
- *       if memory reallocation fails.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
  */
-void brin_trim_start(Brin *b)
+ssize_t brin_read_line(Brin *b, FILE *stream)
 {
-    if (!b || !b->string)
+    if (!b || !b->string || !stream)
     {
-        fprintf(stderr, "Error: input is null\n");
+        fprintf(stderr, "Error: one of the inputs is null\n");
         exit(EXIT_FAILURE);
     }
-
-    char *start = b->string;
-    while (*start && isspace((unsigned char)*start))
-        start++;
-
-    size_t new_len = strlen(start);
-    memmove(b->string, start, new_len + 1);
-    char *new_str = realloc(b->string, new_len + 1);
-    if (!new_str)
+    brin_make_unique(b);
+    ssize_t n = getline(&b->string, &b->capacity, stream);
+    b->hash = 0;
+    if (n < 0)
     {
-        fprintf(stderr, "Error: realloc failed\n");
-        exit(EXIT_FAILURE);
+        if (!b->string)
+        {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        b->string[0] = '\0';
+        b->length = 0;
+        return ferror(stream) ? -1 : 0;
     }
-
-    b->string = new_str;
-    b->length = new_len;
+    b->length = (size_t)n;
+    if (b->string[n - 1] == '\n') b->length--;
+    b->string[b->length] = '\0';
+    return n;
 }
 
 /**
- * @brief Removes trailing whitespace characters from the Brin string.
- *
- * Scans backward from the end of the string, truncates the string
- * at the last non-whitespace character, and reallocates memory
- * to shrink the buffer to the new trimmed length.
+ * @brief Creates a block-buffered reader over a file descriptor.
  *
- * @param[in,out] b Pointer to the Brin instance.
+ * @param fd         File descriptor to read from; it is not closed by the reader.
+ * @param block_size Number of bytes to read at a time, or 0 for 64 KiB.
+ * @return A reader with an empty buffer.
  *
- * @pre Neither `b` nor `b->string` can be NULL.
- * @note The function terminates the program if inputs are invalid or
- *       if memory reallocation fails.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
  */
-void brin_trim_end(Brin *b)
+BrinReader brin_reader_new(int fd, size_t block_size)
 {
-    if (!b || !b->string)
+    if (fd < 0)
     {
-        fprintf(stderr, "Error: input is null\n");
+        fprintf(stderr, "Error: invalid input\n");
         exit(EXIT_FAILURE);
     }
-
-    char *end = b->string + b->length - 1;
-    while (end >= b->string && isspace((unsigned char)*end))
-        end--;
-
-    size_t new_len = (size_t)(end - b->string + 1);
-    b->string[new_len] = '\0';
-
-    char *new_str = realloc(b->string, new_len + 1);
-    if (!new_str)
+    BrinReader r;
+    r.fd = fd;
+    r.capacity = block_size ? block_size : BRIN_CSV_BLOCK;
+    r.start = 0;
+    r.end = 0;
+    r.buffer = malloc(r.capacity);
+    if (!r.buffer)
     {
-        fprintf(stderr, "Error: realloc failed\n");
+        fprintf(stderr, "Error: memory allocation failed\n");
         exit(EXIT_FAILURE);
     }
-
-    b->string = new_str;
-    b->length = new_len;
+    return r;
 }
 
 /**
- * @brief Removes leading and trailing whitespace characters from the Brin string.
- *
- * Calls brin_trim_end to remove trailing spaces, then brin_trim_start
- * to remove leading spaces, effectively trimming the string on both ends.
+ * @brief Frees the buffer of a reader, leaving its file descriptor open.
  *
- * @param[in,out] b Pointer to the Brin instance.
+ * @param r Pointer to the reader to destroy.
  */
-void brin_trim(Brin *b)
+void brin_reader_destroy(BrinReader *r)
 {
-    brin_trim_end(b);
-    brin_trim_start(b);
+    if (!r) return;
+    free(r->buffer);
+    r->buffer = NULL;
+    r->capacity = 0;
+    r->start = 0;
+    r->end = 0;
 }
 
 /**
- * @brief Removes a portion of the string from a Brin object.
+ * @brief Reads the next line of a file descriptor into a Brin, reusing its buffer.
  *
- * This function removes the characters in the range [start, end) from the Brin's string.
- * The operation is performed in-place: the string is modified and reallocated accordingly.
+ * Same as brin_read_line(), for a file descriptor: the reader fetches
+ * whole blocks with `read`, the newline is searched with `memchr` over the
+ * buffered bytes, and the line is copied into the existing allocation of
+ * `b`, which grows only when a line is longer than any before.
  *
- * @param b Pointer to the Brin object to modify.
- * @param start The starting index (inclusive) of the portion to remove.
- * @param end The ending index (exclusive) of the portion to remove.
+ * @param b Pointer to the Brin instance receiving the line.
+ * @param r Pointer to the reader.
+ * @return The number of bytes consumed, newline included, 0 at end of file,
+ *         or -1 on a read error (with `errno` set; `b` then holds the bytes
+ *         of the line read so far).
  *
- * @note If the input is invalid (e.g., NULL pointer, invalid indices), the function
- *       prints an error message to stderr and exits with failure.
- * @note The function allocates a new string and frees the old one. The caller does not need to free anything manually.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
  */
-void brin_remove(Brin *b, int start, int end)
+ssize_t brin_read_line_fd(Brin *b, BrinReader *r)
 {
-    if (!b || !b->string || start < 0 || end < start || end > (int)b->length)
+    if (!b || !b->string || !r || !r->buffer)
     {
-        fprintf(stderr, "Error: invalid input\n");
+        fprintf(stderr, "Error: one of the inputs is null\n");
         exit(EXIT_FAILURE);
     }
-
-    int new_len = b->length - (end - start);
-    char *new_str = malloc(new_len + 1);
-    if (!new_str)
-        return;
-
-    memcpy(new_str, b->string, start);
-    memcpy(new_str + start, b->string + end, b->length - end);
-    new_str[new_len] = '\0';
-
-    free(b->string);
-
-    b->string = new_str;
-    b->length = new_len;
+    brin_make_unique(b);
+    b->length = 0;
+    b->hash = 0;
+    size_t consumed = 0;
+    for (;;)
+    {
+        if (r->start == r->end)
+        {
+            ssize_t n = read(r->fd, r->buffer, r->capacity);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0)
+            {
+                b->string[b->length] = '\0';
+                if (n < 0) return -1;
+                return (ssize_t)consumed;
+            }
+            r->start = 0;
+            r->end = (size_t)n;
+        }
+        const char *chunk = r->buffer + r->start;
+        size_t available = r->end - r->start;
+        const char *newline = memchr(chunk, '\n', available);
+        size_t take = newline ? (size_t)(newline - chunk) : available;
+        brin_reserve(b, b->length + take + 1);
+        memcpy(b->string + b->length, chunk, take);
+        b->length += take;
+        if (newline)
+        {
+            r->start += take + 1;
+            b->string[b->length] = '\0';
+            return (ssize_t)(consumed + take + 1);
+        }
+        r->start = r->end;
+        consumed += take;
+    }
 }
 
 /**
- * @brief Replaces all occurrences of a substring within a Brin string.
+ * @brief Maps a file into memory as a read-only Brin, without copying it.
  *
- * Iterates through the Brin's string, finds each occurrence of `to_replace`,
- * removes that segment, and inserts `replace_by` in its place. Continues until
- * no more occurrences are found.
+ * The Brin reads the file pages directly and works with every function
+ * that does not modify it, such as searching, hashing, splitting, views
+ * and brin_write(). The first modification, or a call to brin_cstr() when
+ * the file does not end with a null byte, copies the content to the heap.
+ * The mapping is released by brin_destroy(), once every share or
+ * substring of it has been destroyed too.
  *
- * @param b            Pointer to the Brin object to modify.
- * @param to_replace   The substring to search for and replace.
- * @param replace_by   The substring to insert in place of each found occurrence.
+ * @param path  Path of the file to map.
+ * @param b     Receives the Brin on success; left untouched on failure.
+ * @param flags Access hints: any of BRIN_MMAP_SEQUENTIAL, BRIN_MMAP_RANDOM
+ *              and BRIN_MMAP_WILLNEED, or 0.
+ * @return 0 on success, -1 if the file cannot be opened, read or mapped
+ *         (with `errno` set).
  *
- * @note Exits with failure if any input pointer is NULL or `to_replace` is empty.
- * @note The function uses a temporary Brin to locate occurrences without
- *       altering the original string prematurely.
+ * @note Changes made to the file while it is mapped show through the Brin.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
  */
-void brin_replace(Brin *b, const char *to_replace, const char *replace_by)
+int brin_map_file(const char *path, Brin *b, int flags)
 {
-    if (!b || !to_replace || !replace_by || !*to_replace)
+    if (!path || !b)
     {
-        fprintf(stderr, "Error: invalid input\n");
+        fprintf(stderr, "Error: one of the inputs is null\n");
         exit(EXIT_FAILURE);
     }
-
-    size_t len_old = strlen(to_replace);
-    size_t len_new = strlen(replace_by);
-    int offset = 0;
-
-    while (1)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) < 0)
     {
-        Brin temp = brin_new(b->string + offset);
-        int local_index = temp.index_of(&temp, to_replace);
-        brin_destroy(&temp);
-
-        if (local_index == -1)
-            break;
-
-        int global_index = offset + local_index;
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    if (st.st_size == 0)
+    {
+        close(fd);
+        *b = brin_new_n(NULL, 0);
+        return 0;
+    }
 
-        brin_remove(b, global_index, global_index + len_old);
-        brin_insert(b, global_index, replace_by);
+    size_t size = (size_t)st.st_size;
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int saved = errno;
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        errno = saved;
+        return -1;
+    }
+    if (flags & BRIN_MMAP_SEQUENTIAL)
+        posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+    if (flags & BRIN_MMAP_RANDOM)
+        posix_madvise(data, size, POSIX_MADV_RANDOM);
+    if (flags & BRIN_MMAP_WILLNEED)
+        posix_madvise(data, size, POSIX_MADV_WILLNEED);
 
-        offset = global_index + len_new;
+    struct BrinShared *shared = malloc(sizeof(*shared));
+    if (!shared)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
     }
+    brin_ref_init(&shared->refs, 1);
+    shared->base = data;
+    shared->mapped = size;
+    shared->writable = 0;
+
+    b->string = data;
+    b->length = size;
+    b->capacity = 0;
+    b->hash = 0;
+    b->shared = shared;
+    b->cord = NULL;
+    brin_bind_methods(b);
+    return 0;
 }
 
 /**
- * @brief Splits the string inside a Brin object into a NULL-terminated array of strings.
- *
- * This function takes a Brin pointer and a separator string, then splits the Brin's string
- * by occurrences of the separator. It returns a dynamically allocated NULL-terminated array
- * of strings, each string is separately allocated and must be freed by the caller.
+ * @brief Creates an empty Brin stored in an anonymous memory mapping.
  *
- * @param b Pointer to the Brin object containing the string to split.
- * @param sep The separator string used to split the input string.
+ * Meant for very large outputs built by appending: brin_concat(),
+ * brin_concat_n() and flattening lazy pieces write into the mapping and
+ * grow it with `mremap`, which moves page table entries instead of copying
+ * the bytes as `realloc` may do. Any other modification, a share that gets
+ * modified, or brin_release() moves the content back to the heap first.
  *
- * @return A NULL-terminated array of dynamically allocated strings resulting from the split.
+ * @param capacity Initial size in bytes, rounded up to whole pages.
+ * @param flags    BRIN_MMAP_HUGEPAGES to ask for transparent huge pages, or 0.
+ * @return An empty Brin backed by the mapping.
  *
- * @note The caller is responsible for freeing each string in the returned array,
- *       as well as the array pointer itself.
- * @note The function will exit with failure if input pointers are NULL or memory allocation fails.
+ * @note Without `mremap` (outside Linux), growing maps a larger region and copies into it.
+ * @note The function exits the program if memory allocation fails.
  */
-char **brin_split(Brin *b, const char *sep)
+Brin brin_new_mapped(size_t capacity, int flags)
 {
-    if (!b || !b->string || !sep)
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = capacity ? (capacity + page - 1) / page * page : page;
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    struct BrinShared *shared = malloc(sizeof(*shared));
+    if (data == MAP_FAILED || !shared)
     {
-        fprintf(stderr, "Error: one of the inputs is null\n");
+        fprintf(stderr, "Error: memory allocation failed\n");
         exit(EXIT_FAILURE);
     }
+#if defined(MADV_HUGEPAGE)
+    if (flags & BRIN_MMAP_HUGEPAGES) madvise(data, size, MADV_HUGEPAGE);
+#else
+    (void)flags;
+#endif
+    brin_ref_init(&shared->refs, 1);
+    shared->base = data;
+    shared->mapped = size;
+    shared->writable = 1;
 
-    char *copy = strdup(b->string);
-    if (!copy)
+    Brin b;
+    b.string = data;
+    b.string[0] = '\0';
+    b.length = 0;
+    b.capacity = size;
+    b.hash = 0;
+    b.shared = shared;
+    b.cord = NULL;
+    brin_bind_methods(&b);
+    return b;
+}
+
+/*
+ * Opens `path` and gives `out` an uninitialized buffer sized for the whole
+ * file. Returns the descriptor, or -1 with *error set and `out` empty.
+ */
+static int brin_load_open(const char *path, Brin *out, int *error)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0)
+    {
+        *error = errno;
+        if (fd >= 0) close(fd);
+        *out = brin_new_n(NULL, 0);
+        return -1;
+    }
+    size_t size = st.st_size > 0 ? (size_t)st.st_size : 0;
+    char *buffer = malloc(size + 1);
+    if (!buffer)
     {
         fprintf(stderr, "Error: memory allocation failed\n");
         exit(EXIT_FAILURE);
     }
+    *out = brin_adopt(buffer, size, size + 1);
+    *error = 0;
+    return fd;
+}
 
-    size_t count = 0;
-    char *temp = strdup(copy);
-    char *token = strtok(temp, sep);
-    while (token)
+/*
+ * Settles file `i` once read: `done` bytes were read, or -1 on `error`, in
+ * which case its Brin is emptied.
+ */
+static void brin_load_finish(Brin *out, int *errors, size_t i, ssize_t done,
+                             int error)
+{
+    if (done < 0)
     {
-        count++;
-        token = strtok(NULL, sep);
+        brin_destroy(&out[i]);
+        out[i] = brin_new_n(NULL, 0);
+    }
+    else
+    {
+        out[i].length = (size_t)done;
+        out[i].string[done] = '\0';
+        error = 0;
     }
-    free(temp);
+    if (errors) errors[i] = error;
+}
 
-    char **array = malloc((count + 1) * sizeof(char*));
-    if (!array)
+/*
+ * Reads the rest of a file opened by brin_load_open() with pread, from
+ * offset `done`. Returns the total read, less than the buffer if the file
+ * shrank, or -1 with *error set.
+ */
+static ssize_t brin_load_pread(int fd, Brin *b, size_t done, int *error)
+{
+    while (done < b->length)
     {
-        free(copy);
-        fprintf(stderr, "Error: memory allocation failed\n");
-        exit(EXIT_FAILURE);
+        ssize_t n = pread(fd, b->string + done, b->length - done, (off_t)done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0)
+        {
+            *error = errno;
+            return -1;
+        }
+        if (n == 0) break;
+        done += (size_t)n;
     }
+    return (ssize_t)done;
+}
 
-    size_t i = 0;
-    token = strtok(copy, sep);
-    while (token)
+/* Slice of the files loaded by one fallback thread. */
+struct BrinLoadJob
+{
+    const char *const *paths;
+    Brin *out;
+    int *errors;
+    size_t start;
+    size_t count;
+    size_t stride;
+};
+
+/* Loads files start, start + stride, ... of a job with open and pread. */
+static void *brin_load_worker(void *arg)
+{
+    struct BrinLoadJob *job = arg;
+    for (size_t i = job->start; i < job->count; i += job->stride)
     {
-        array[i] = strdup(token);
-        if (!array[i])
+        int error;
+        int fd = brin_load_open(job->paths[i], &job->out[i], &error);
+        if (fd < 0)
         {
-            for (size_t j = 0; j < i; j++) free(array[j]);
-            free(array);
-            free(copy);
-            fprintf(stderr, "Error: memory allocation failed\n");
-            exit(EXIT_FAILURE);
+            if (job->errors) job->errors[i] = error;
+            continue;
         }
-        i++;
-        token = strtok(NULL, sep);
+        ssize_t done = brin_load_pread(fd, &job->out[i], 0, &error);
+        close(fd);
+        brin_load_finish(job->out, job->errors, i, done, error);
     }
-    array[i] = NULL;
+    return NULL;
+}
 
-    free(copy);
-    return array;
+/* Loads every file on a pool of threads, each reading its own slice. */
+static void brin_load_threads(const char *const *paths, size_t count,
+                              Brin *out, int *errors)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t threads = cpus > 0 ? (size_t)cpus : 1;
+    if (threads > BRIN_LOAD_THREADS) threads = BRIN_LOAD_THREADS;
+    if (threads > count) threads = count;
+
+    pthread_t ids[BRIN_LOAD_THREADS];
+    int running[BRIN_LOAD_THREADS] = {0};
+    struct BrinLoadJob jobs[BRIN_LOAD_THREADS];
+    for (size_t t = 0; t < threads; ++t)
+    {
+        struct BrinLoadJob job = { paths, out, errors, t, count, threads };
+        jobs[t] = job;
+        if (t > 0)
+            running[t] = pthread_create(&ids[t], NULL, brin_load_worker,
+                                        &jobs[t]) == 0;
+    }
+    for (size_t t = 0; t < threads; ++t)
+    {
+        if (!running[t]) brin_load_worker(&jobs[t]);
+    }
+    for (size_t t = 1; t < threads; ++t)
+    {
+        if (running[t]) pthread_join(ids[t], NULL);
+    }
 }
 
-/**
- * @brief Frees the memory used by the string in the Brin instance and resets its state.
- *
- * This function releases the allocated memory for the string inside the given Brin object,
- * sets the string pointer to NULL, and resets the length to zero.
- * If the BRIN_LITE mode is not enabled, it also clears all function pointers to avoid dangling references.
- *
- * @param b Pointer to the Brin instance to destroy.
- */
-void brin_destroy(Brin *b)
+#if defined(BRIN_IO_URING)
+/* Submission and completion rings of an io_uring instance, mapped in. */
+struct BrinRing
 {
-    if (b && b->string) free(b->string);
-    b->string = NULL;
-    b->length = 0;
-#ifndef BRIN_LITE
-    b->destroy = NULL;
-    b->concat = NULL;
-    b->contains = NULL;
-    b->equals = NULL;
-    b->index_of = NULL;
-    b->insert = NULL;
-    b->is_empty = NULL;
-    b->is_whitespace = NULL;
-    b->to_lower = NULL;
-    b->to_upper = NULL;
-    b->trim_start = NULL;
-    b->trim_end = NULL;
-    b->trim = NULL;
-    b->split = NULL;
-    b->remove = NULL;
-    b->replace = NULL;
-#endif
+    int fd;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    void *sq_ring;
+    void *cq_ring;
+    size_t sq_size;
+    size_t cq_size;
+    size_t sqes_size;
+};
+
+/* Sets up a ring of `entries` slots. Returns 0, or -1 if unavailable. */
+static int brin_ring_init(struct BrinRing *r, unsigned entries)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    r->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (r->fd < 0) return -1;
+
+    r->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (r->cq_size > r->sq_size) r->sq_size = r->cq_size;
+        r->cq_size = r->sq_size;
+    }
+    r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sq_ring = mmap(NULL, r->sq_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+    r->cq_ring = r->sq_ring;
+    if (r->sq_ring != MAP_FAILED && !(p.features & IORING_FEAT_SINGLE_MMAP))
+        r->cq_ring = mmap(NULL, r->cq_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+    r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+    if (r->sq_ring == MAP_FAILED || r->cq_ring == MAP_FAILED
+            || r->sqes == MAP_FAILED)
+    {
+        if (r->sqes != MAP_FAILED) munmap(r->sqes, r->sqes_size);
+        if (r->cq_ring != MAP_FAILED && r->cq_ring != r->sq_ring)
+            munmap(r->cq_ring, r->cq_size);
+        if (r->sq_ring != MAP_FAILED) munmap(r->sq_ring, r->sq_size);
+        close(r->fd);
+        return -1;
+    }
+
+    char *sq = r->sq_ring, *cq = r->cq_ring;
+    r->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned *)(sq + p.sq_off.array);
+    r->cq_head = (unsigned *)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
 }
 
-/**
- * @brief Creates a new Brin instance initialized with the given string.
- *
- * Allocates memory for the string, copies the input string into the newly created Brin,
- * initializes the length field, and sets function pointers if BRIN_LITE mode is not active.
- *
- * @param string The C-string to initialize the Brin with. Must not be NULL.
- * @return A Brin instance containing a copy of the input string.
- *
- * @note This function exits the program with an error if the input string is NULL
- *       or if memory allocation fails.
+static void brin_ring_destroy(struct BrinRing *r)
+{
+    munmap(r->sqes, r->sqes_size);
+    if (r->cq_ring != r->sq_ring) munmap(r->cq_ring, r->cq_size);
+    munmap(r->sq_ring, r->sq_size);
+    close(r->fd);
+}
+
+/* Queues a read of len bytes at `offset` into `buffer`, tagged with `tag`. */
+static void brin_ring_read(struct BrinRing *r, int fd, char *buffer,
+                           size_t len, size_t offset, uint64_t tag)
+{
+    unsigned tail = *r->sq_tail;
+    unsigned index = tail & *r->sq_mask;
+    struct io_uring_sqe *sqe = &r->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->addr = (uint64_t)(uintptr_t)buffer;
+    sqe->len = len > 0x7FFFF000 ? 0x7FFFF000 : (unsigned)len;
+    sqe->user_data = tag;
+    r->sq_array[index] = index;
+    __atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Loads files [first, first + count) with one io_uring read per file in
+ * flight, requeueing short reads. Returns -1 if the kernel refuses the
+ * batch, leaving the remaining files to the caller.
  */
-Brin brin_new(const char *string)
+static int brin_load_ring(struct BrinRing *r, const char *const *paths,
+                          size_t first, size_t count, Brin *out, int *errors)
 {
-    if (!string)
+    int fds[BRIN_LOAD_WINDOW];
+    size_t done[BRIN_LOAD_WINDOW];
+    unsigned queued = 0, pending = 0;
+    int refused = 0;
+    for (size_t k = 0; k < count; ++k)
     {
-        fprintf(stderr, "Error: null string input\n");
-        exit(EXIT_FAILURE);
+        size_t i = first + k;
+        int error;
+        fds[k] = brin_load_open(paths[i], &out[i], &error);
+        done[k] = 0;
+        if (fds[k] < 0)
+        {
+            if (errors) errors[i] = error;
+            continue;
+        }
+        if (out[i].length == 0)
+        {
+            close(fds[k]);
+            fds[k] = -1;
+            brin_load_finish(out, errors, i, 0, 0);
+            continue;
+        }
+        brin_ring_read(r, fds[k], out[i].string, out[i].length, 0, k);
+        queued++;
     }
-    Brin b;
-    b.length = strlen(string);
-    b.string = malloc(b.length + 1);
-    if (!b.string)
+
+    while ((queued && !refused) || pending)
     {
-        fprintf(stderr, "Error: memory allocation\n");
-        exit(EXIT_FAILURE);
+        long n = syscall(__NR_io_uring_enter, r->fd, refused ? 0 : queued, 1,
+                         IORING_ENTER_GETEVENTS, NULL, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && !pending) break;
+        if (n < 0)
+        {
+            refused = 1;
+            continue;
+        }
+        pending += (unsigned)n;
+        queued -= (unsigned)n;
+
+        unsigned head = *r->cq_head;
+        unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head)
+        {
+            struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+            size_t k = (size_t)cqe->user_data, i = first + k;
+            int res = cqe->res;
+            pending--;
+            if (res > 0) done[k] += (size_t)res;
+            if (res > 0 && done[k] < out[i].length)
+            {
+                brin_ring_read(r, fds[k], out[i].string + done[k],
+                               out[i].length - done[k], done[k], k);
+                queued++;
+                continue;
+            }
+            ssize_t total = (ssize_t)done[k];
+            int error = 0;
+            if (res == -EINVAL || res == -EOPNOTSUPP)
+                total = brin_load_pread(fds[k], &out[i], done[k], &error);
+            else if (res < 0)
+            {
+                total = -1;
+                error = -res;
+            }
+            close(fds[k]);
+            fds[k] = -1;
+            brin_load_finish(out, errors, i, total, error);
+        }
+        __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
     }
-    strcpy(b.string, string);
-#ifndef BRIN_LITE
-    b.destroy = brin_destroy;
-    b.concat = brin_concat;
-    b.contains = brin_contains;
-    b.equals = brin_equals;
-    b.index_of = brin_index_of;
-    b.insert = brin_insert;
-    b.is_empty = brin_is_empty;
-    b.is_whitespace = brin_is_whitespace;
-    b.to_lower = brin_to_lower;
-    b.to_upper = brin_to_upper;
-    b.trim_start = brin_trim_start;
-    b.trim_end = brin_trim_end;
-    b.trim = brin_trim;
-    b.split = brin_split;
-    b.remove = brin_remove;
-    b.replace = brin_replace;
-#endif
-    return b;
+
+    if (!queued) return 0;
+    for (size_t k = 0; k < count; ++k)
+    {
+        if (fds[k] < 0) continue;
+        int error;
+        ssize_t total = brin_load_pread(fds[k], &out[first + k], done[k],
+                                        &error);
+        close(fds[k]);
+        brin_load_finish(out, errors, first + k, total, error);
+    }
+    return -1;
 }
+#endif
 
 /**
- * @brief Joins an array of C strings into a single Brin, separated by `sep`.
+ * @brief Reads many files concurrently into pre-sized Brins.
  *
- * @param array  Array of C strings to join.
- * @param length Number of elements in the array.
- * @param sep    Separator string (can be empty, but not NULL).
- * @return Brin  The joined string.
+ * Each file is opened and measured, then read straight into a Brin
+ * allocated at its exact size. On Linux the reads are batched through
+ * io_uring; where it is unavailable (older kernels, sandboxes, or builds
+ * with BRIN_NO_IO_URING), the files are read with `pread` on a small pool
+ * of threads instead.
+ *
+ * @param paths  Array of `count` file paths.
+ * @param count  Number of files.
+ * @param out    Array of `count` Brins receiving the contents, to be
+ *               destroyed by the caller; a file that cannot be read gets
+ *               an empty Brin.
+ * @param errors If not NULL, receives an `errno` value per file, 0 when it
+ *               was read.
+ * @return The number of files read successfully.
+ *
+ * @note Files are read up to the size they had when opened.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
  */
-Brin brin_join(const char **array, size_t length, const char *sep)
+size_t brin_load_files(const char *const *paths, size_t count, Brin *out,
+                       int *errors)
 {
-    if (!array)
-    {
-        fprintf(stderr, "Error: input array is NULL\n");
-        exit(EXIT_FAILURE);
-    }
-    if (!sep)
+    if ((!paths || !out) && count)
     {
-        fprintf(stderr, "Error: separator is NULL\n");
+        fprintf(stderr, "Error: one of the inputs is null\n");
         exit(EXIT_FAILURE);
     }
-    Brin b = brin_new("");
-    for (size_t i = 0; i < length; ++i)
+    for (size_t i = 0; i < count; ++i)
     {
-        if (!array[i])
+        if (!paths[i])
         {
-            fprintf(stderr, "Error: array[%zu] is NULL\n", i);
-            brin_destroy(&b);
+            fprintf(stderr, "Error: paths[%zu] is NULL\n", i);
             exit(EXIT_FAILURE);
         }
-        brin_concat(&b, array[i]);
-        if (i < length - 1)
+    }
+
+    int *status = errors ? errors : malloc(count * sizeof(*status) + 1);
+    if (!status)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t loaded = 0;
+#if defined(BRIN_IO_URING)
+    struct BrinRing ring;
+    if (count && brin_ring_init(&ring, BRIN_LOAD_WINDOW) == 0)
+    {
+        while (loaded < count)
         {
-            brin_concat(&b, sep);
+            size_t batch = count - loaded;
+            if (batch > BRIN_LOAD_WINDOW) batch = BRIN_LOAD_WINDOW;
+            int refused = brin_load_ring(&ring, paths, loaded, batch, out,
+                                         status) < 0;
+            loaded += batch;
+            if (refused) break;
         }
+        brin_ring_destroy(&ring);
     }
-    return b;
-}
\ No newline at end of file
+#endif
+    if (loaded < count)
+        brin_load_threads(paths + loaded, count - loaded, out + loaded,
+                          status + loaded);
+
+    size_t succeeded = 0;
+    for (size_t i = 0; i < count; ++i) succeeded += status[i] == 0;
+    if (status != errors) free(status);
+    return succeeded;
+}
+
+/**
+ * @brief Returns the CPU features used by the SIMD kernels of the library.
+ *
+ * Searching, case conversion, trimming, splitting and CSV parsing each have
+ * scalar, SSE2 and, on x86, SSE4.2 or AVX2 kernels. The best one for the
+ * running CPU is picked once, when the library is loaded, so a single
+ * binary runs at full speed across CPU generations. Setting the environment
+ * variable `BRIN_CPU` to `scalar`, `sse2`, `sse4.2` or `avx2` before the
+ * program starts caps the level, e.g. to compare kernels in benchmarks.
+ *
+ * @return A combination of BRIN_CPU_SSE2, BRIN_CPU_SSE42 and BRIN_CPU_AVX2
+ *         naming the kernels in use, 0 for the scalar ones.
+ */
+unsigned brin_cpu_features(void)
+{
+    brin_kernels();
+    return brin_features;
+}
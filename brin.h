@@ -31,6 +31,9 @@
 #define BRIN_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
 
 /**
  * @struct Brin
@@ -47,13 +50,47 @@
 typedef struct Brin
 {
     /**
-     * @brief Pointer to the null-terminated string buffer.
+     * @brief Pointer to the string buffer.
+     *
+     * May contain null bytes: `length` is authoritative and every function
+     * works on `length` bytes. Null-terminated, except for shared substrings created by
+     * brin_substr_shared(), and incomplete while lazy pieces are pending
+     * (see `cord`); brin_cstr() always returns the full terminated string.
      */
     char *string;
     /**
      * @brief Length of the string (excluding the null terminator).
      */
     size_t length;
+    /**
+     * @brief Size in bytes of the allocation holding `string`, terminator included.
+     *
+     * Only meaningful while the Brin owns its buffer alone (`shared` is NULL)
+     * or owns the mapping of brin_new_mapped(); appends use the spare room
+     * before growing the buffer geometrically.
+     */
+    size_t capacity;
+    /**
+     * @brief Cached 64-bit hash of the content, 0 while not computed.
+     *
+     * Filled lazily by hash-based comparisons and reset by every mutating
+     * function. Code writing to `string` directly must reset it to 0.
+     */
+    uint64_t hash;
+    /**
+     * @brief Reference-counted control block when the buffer is shared, NULL otherwise.
+     *
+     * Set by brin_share(). Mutating functions copy the buffer first while
+     * other Brins still reference it.
+     */
+    struct BrinShared *shared;
+    /**
+     * @brief Pieces appended by brin_concat_lazy() and not yet copied, NULL when none.
+     *
+     * While set, `length` counts the pending pieces but `string` only holds
+     * the prefix before them; brin_cstr() and every other function flatten them.
+     */
+    struct BrinCord *cord;
 
 #ifndef BRIN_LITE
     /**
@@ -129,6 +166,25 @@ typedef struct Brin
 
 } Brin;
 
+/**
+ * @struct BrinView
+ * @brief Non-owning view over a span of bytes.
+ *
+ * A view does not own its bytes and is not necessarily null-terminated.
+ * It stays valid as long as the underlying buffer is neither freed nor modified.
+ */
+typedef struct BrinView
+{
+    /**
+     * @brief Pointer to the first byte of the span.
+     */
+    const char *data;
+    /**
+     * @brief Number of bytes in the span.
+     */
+    size_t length;
+} BrinView;
+
 /**
  * @brief Creates a new Brin instance initialized with the given string.
  *
@@ -143,6 +199,21 @@ typedef struct Brin
  */
 Brin brin_new(const char *string);
 
+/**
+ * @brief Creates a new Brin instance initialized with `length` bytes.
+ *
+ * Same as brin_new() without measuring the input: exactly `length` bytes
+ * are copied, including any null byte, and a terminator is appended.
+ *
+ * @param string The bytes to copy (may be NULL only if `length` is 0).
+ * @param length Number of bytes to copy.
+ * @return A Brin instance containing a copy of the bytes.
+ *
+ * @note This function exits the program with an error if the input is invalid
+ *       or if memory allocation fails.
+ */
+Brin brin_new_n(const char *string, size_t length);
+
 /**
  * @brief Frees the memory used by the string in the Brin instance and resets its state.
  *
@@ -171,6 +242,21 @@ void brin_destroy(Brin *b);
  */
 void brin_concat(Brin *b, const char *suffix);
 
+/**
+ * @brief Append `length` bytes to a Brin string, resizing memory as needed.
+ *
+ * Same as brin_concat() without measuring the suffix: the bytes are copied
+ * as-is, including any null byte. The suffix may point inside `b` itself.
+ *
+ * @param[in,out] b Pointer to the Brin instance to modify.
+ * @param[in] suffix Bytes to append (may be NULL only if `length` is 0).
+ * @param[in] length Number of bytes to append.
+ *
+ * @note The function will exit the program if any input is NULL
+ *       or if memory allocation fails.
+ */
+void brin_concat_n(Brin *b, const char *suffix, size_t length);
+
 /**
  * @brief Check if the Brin string contains a given substring.
  *
@@ -188,6 +274,22 @@ void brin_concat(Brin *b, const char *suffix);
  */
 int brin_contains(Brin *b, const char *string);
 
+/**
+ * @brief Check if the Brin string contains a given sequence of bytes.
+ *
+ * Same as brin_contains() with an explicit substring length, so the
+ * substring may contain null bytes.
+ *
+ * @param[in] b Pointer to the Brin instance to check.
+ * @param[in] string Bytes to search for (may be NULL only if `length` is 0).
+ * @param[in] length Number of bytes to search for.
+ *
+ * @return 1 if the substring is found, 0 otherwise.
+ *
+ * @note The function will exit the program if any input is NULL.
+ */
+int brin_contains_n(Brin *b, const char *string, size_t length);
+
 /**
  * @brief Compare the Brin string with a null-terminated string for equality.
  *
@@ -205,6 +307,22 @@ int brin_contains(Brin *b, const char *string);
  */
 int brin_equals(Brin *b, const char *string);
 
+/**
+ * @brief Compare the Brin string with a sequence of bytes for equality.
+ *
+ * Lengths are compared first, so strings of different lengths are told
+ * apart without reading them.
+ *
+ * @param[in] b Pointer to the Brin instance.
+ * @param[in] string Bytes to compare with (may be NULL only if `length` is 0).
+ * @param[in] length Number of bytes to compare with.
+ *
+ * @return 1 if both hold the same bytes, 0 otherwise.
+ *
+ * @note The function terminates the program if any input pointer is NULL.
+ */
+int brin_equals_n(Brin *b, const char *string, size_t length);
+
 /**
  * @brief Finds the first occurrence index of a substring within the Brin string.
  *
@@ -223,6 +341,22 @@ int brin_equals(Brin *b, const char *string);
  */
 int brin_index_of(Brin *b, const char *string);
 
+/**
+ * @brief Finds the first occurrence index of a sequence of bytes within the Brin string.
+ *
+ * Same as brin_index_of() with an explicit substring length, so the
+ * substring may contain null bytes.
+ *
+ * @param[in] b Pointer to the Brin instance.
+ * @param[in] string Bytes to search for (may be NULL only if `length` is 0).
+ * @param[in] length Number of bytes to search for.
+ *
+ * @return The zero-based index of the first occurrence, or -1 if not found.
+ *
+ * @note The function terminates the program if any input pointer is NULL.
+ */
+int brin_index_of_n(Brin *b, const char *string, size_t length);
+
 /**
  * @brief Inserts a substring into the Brin string at a specified index.
  *
@@ -242,6 +376,21 @@ int brin_index_of(Brin *b, const char *string);
  */
 void brin_insert(Brin *b, int index, const char *string);
 
+/**
+ * @brief Inserts a sequence of bytes into the Brin string at a specified index.
+ *
+ * Same as brin_insert() with an explicit length, so the inserted bytes may
+ * contain null bytes. They may also point inside `b` itself.
+ *
+ * @param[in,out] b Pointer to the Brin instance.
+ * @param[in] index Position at which to insert the bytes (0 ≤ index ≤ b->length).
+ * @param[in] string Bytes to insert (may be NULL only if `length` is 0).
+ * @param[in] length Number of bytes to insert.
+ *
+ * @note The function terminates the program if inputs are invalid or memory allocation fails.
+ */
+void brin_insert_n(Brin *b, int index, const char *string, size_t length);
+
 /**
  * @brief Checks if the Brin string is empty.
  *
@@ -348,6 +497,25 @@ void brin_trim(Brin *b);
  */
 Brin brin_join(const char **array, size_t length, const char *sep);
 
+/**
+ * @brief Joins an array of byte sequences into a single Brin, separated by `sep`.
+ *
+ * The total length is computed first, so the result is built in a single
+ * allocation. C strings are then copied up to their terminator instead of
+ * being measured a second time.
+ *
+ * @param array   Array of byte sequences to join.
+ * @param lengths Length of each element, or NULL if the elements are C strings.
+ * @param count   Number of elements in the array.
+ * @param sep     Separator bytes (may be NULL only if `sep_len` is 0).
+ * @param sep_len Number of bytes in the separator.
+ * @return Brin   The joined string.
+ *
+ * @note The function exits the program if an input is NULL or memory allocation fails.
+ */
+Brin brin_join_n(const char **array, const size_t *lengths, size_t count,
+                 const char *sep, size_t sep_len);
+
 /**
  * @brief Splits the string inside a Brin object into a NULL-terminated array of strings.
  *
@@ -355,6 +523,10 @@ Brin brin_join(const char **array, size_t length, const char *sep);
  * by occurrences of the separator. It returns a dynamically allocated NULL-terminated array
  * of strings, each string is separately allocated and must be freed by the caller.
  *
+ * As with `strtok`, every byte of `sep` is a delimiter, runs of delimiters are collapsed
+ * and empty tokens are skipped. The content is scanned up to `b->length`, so null bytes
+ * inside it are kept in the tokens (which then read as shorter C strings).
+ *
  * @param b Pointer to the Brin object containing the string to split.
  * @param sep The separator string used to split the input string.
  *
@@ -366,6 +538,49 @@ Brin brin_join(const char **array, size_t length, const char *sep);
  */
 char **brin_split(Brin *b, const char *sep);
 
+/**
+ * @brief Splits the content of a Brin into at most `max_fields` strings.
+ *
+ * Tokens follow the same rules as brin_split() until `max_fields - 1`
+ * tokens have been found. The last field then holds the unsplit remainder,
+ * starting at its first non-delimiter byte, and the rest of the content is
+ * never scanned. A `max_fields` of 0 means no limit.
+ *
+ * @param b          Pointer to the Brin instance to split.
+ * @param sep        The null-terminated set of delimiter bytes.
+ * @param max_fields Maximum number of fields to return, or 0 for no limit.
+ * @return A NULL-terminated array of dynamically allocated strings.
+ *
+ * @note The caller is responsible for freeing each string in the returned array,
+ *       as well as the array pointer itself.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+char **brin_split_n(Brin *b, const char *sep, size_t max_fields);
+
+/**
+ * @brief Splits the content of a Brin into a NULL-terminated array held in one allocation.
+ *
+ * Tokens follow the same rules as brin_split(), but the pointer array and
+ * every null-terminated token are laid out in a single block, sized exactly
+ * after a counting pass: the tokens are stored right after the array.
+ *
+ * @param b   Pointer to the Brin instance to split.
+ * @param sep The null-terminated set of delimiter bytes.
+ * @return A NULL-terminated array of tokens.
+ *
+ * @note Release the result with brin_split_free() or a single free(); the
+ *       tokens must not be freed individually.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+char **brin_split_packed(Brin *b, const char *sep);
+
+/**
+ * @brief Frees an array returned by brin_split_packed().
+ *
+ * @param array The array to free (may be NULL).
+ */
+void brin_split_free(char **array);
+
 /**
  * @brief Removes a portion of the string from a Brin object.
  *
@@ -394,9 +609,993 @@ void brin_remove(Brin *b, int start, int end);
  * @param replace_by   The substring to insert in place of each found occurrence.
  *
  * @note Exits with failure if any input pointer is NULL or `to_replace` is empty.
- * @note The function uses a temporary Brin to locate occurrences without
- *       altering the original string prematurely.
+ * @note Occurrences are located first and the result is built in a single
+ *       allocation, see brin_replace_n().
  */
 void brin_replace(Brin *b, const char *to_replace, const char *replace_by);
 
+/**
+ * @brief Replaces all occurrences of a sequence of bytes within a Brin string.
+ *
+ * Same as brin_replace() with explicit lengths. Occurrences are found from
+ * left to right without overlapping, counted in a first pass, and the
+ * result is built in a single allocation in a second pass.
+ *
+ * @param b              Pointer to the Brin object to modify.
+ * @param to_replace     Bytes to search for and replace.
+ * @param to_replace_len Number of bytes in `to_replace` (must not be 0).
+ * @param replace_by     Bytes to insert in place of each occurrence.
+ * @param replace_by_len Number of bytes in `replace_by`.
+ *
+ * @note Exits with failure if any input pointer is NULL, `to_replace_len` is 0,
+ *       or memory allocation fails.
+ */
+void brin_replace_n(Brin *b, const char *to_replace, size_t to_replace_len,
+                    const char *replace_by, size_t replace_by_len);
+
+/**
+ * @struct BrinInternTable
+ * @brief Open-addressing table mapping bytes to canonical immutable Brins.
+ *
+ * Each distinct byte sequence is stored once. Handles returned for equal
+ * bytes are the same pointer, so interned strings compare by address.
+ */
+typedef struct BrinInternTable
+{
+    /**
+     * @brief Hash of the entry in each slot.
+     */
+    uint64_t *hashes;
+    /**
+     * @brief Canonical Brin in each slot, NULL for empty slots.
+     */
+    Brin **entries;
+    /**
+     * @brief Number of slots (a power of two).
+     */
+    size_t capacity;
+    /**
+     * @brief Number of distinct strings held.
+     */
+    size_t count;
+} BrinInternTable;
+
+/**
+ * @struct BrinMap
+ * @brief Open-addressing hash map from byte strings to `void *` values.
+ *
+ * The table follows the SwissTable design: one control byte per slot holds
+ * 7 bits of the hash (or an empty/deleted marker), and lookups compare a
+ * whole group of 16 control bytes at once with SSE2 before touching any key.
+ * Slots are stored as separate arrays (control bytes, hashes, keys, key
+ * lengths, values) so probing only reads the arrays it needs.
+ */
+typedef struct BrinMap
+{
+    /**
+     * @brief Control byte of each slot.
+     */
+    uint8_t *ctrl;
+    /**
+     * @brief Full hash of each occupied slot.
+     */
+    uint64_t *hashes;
+    /**
+     * @brief Owned, null-terminated copy of each occupied slot's key.
+     */
+    char **keys;
+    /**
+     * @brief Length of each occupied slot's key.
+     */
+    size_t *key_lengths;
+    /**
+     * @brief Value of each occupied slot.
+     */
+    void **values;
+    /**
+     * @brief Number of slots (a power of two, multiple of 16).
+     */
+    size_t capacity;
+    /**
+     * @brief Number of entries.
+     */
+    size_t count;
+    /**
+     * @brief Number of empty slots that may still be filled before growing.
+     */
+    size_t growth_left;
+} BrinMap;
+
+/**
+ * @struct BrinColumn
+ * @brief A list of byte strings packed into one contiguous byte pool.
+ *
+ * Field `i` occupies `bytes[offsets[i] .. offsets[i + 1])`, so the whole
+ * column lives in two allocations regardless of how many fields it holds,
+ * and walking the fields is a sequential scan of the pool. Fields are not
+ * null-terminated; read them as BrinView with brin_column_get().
+ */
+typedef struct BrinColumn
+{
+    /**
+     * @brief Byte pool holding the fields back to back.
+     */
+    char *bytes;
+    /**
+     * @brief Start offset of each field in `bytes`, plus the end of the last one.
+     *
+     * Holds `count + 1` entries; `offsets[0]` is always 0.
+     */
+    size_t *offsets;
+    /**
+     * @brief Number of fields.
+     */
+    size_t count;
+    /**
+     * @brief Allocated size of `bytes`.
+     */
+    size_t bytes_capacity;
+    /**
+     * @brief Allocated number of entries in `offsets`.
+     */
+    size_t offsets_capacity;
+} BrinColumn;
+
+/**
+ * @struct BrinCsv
+ * @brief Records parsed from CSV or TSV text.
+ *
+ * Every field of every record is stored unescaped, in order, in one
+ * BrinColumn; `record_ends` tells where each record stops in that column.
+ */
+typedef struct BrinCsv
+{
+    /**
+     * @brief All fields of all records, quotes removed and `""` collapsed.
+     */
+    BrinColumn fields;
+    /**
+     * @brief Index in `fields` one past the last field of each record.
+     */
+    size_t *record_ends;
+    /**
+     * @brief Number of records.
+     */
+    size_t records;
+    /**
+     * @brief Allocated number of entries in `record_ends`.
+     */
+    size_t records_capacity;
+    /**
+     * @brief Field delimiter, such as `,` or `\t`.
+     */
+    char delimiter;
+} BrinCsv;
+
+/**
+ * @struct BrinReader
+ * @brief Block-buffered reader over a file descriptor, for brin_read_line_fd().
+ */
+typedef struct BrinReader
+{
+    /**
+     * @brief File descriptor being read.
+     */
+    int fd;
+    /**
+     * @brief Block buffer holding bytes read but not yet returned.
+     */
+    char *buffer;
+    /**
+     * @brief Size of `buffer`.
+     */
+    size_t capacity;
+    /**
+     * @brief Offset of the first unreturned byte in `buffer`.
+     */
+    size_t start;
+    /**
+     * @brief Offset one past the last byte read into `buffer`.
+     */
+    size_t end;
+} BrinReader;
+
+/**
+ * @brief Returns a view over the whole content of a Brin.
+ *
+ * @param b Pointer to the Brin instance.
+ * @return A BrinView covering `b->string` and `b->length`.
+ *
+ * @note The function terminates the program if inputs are invalid.
+ */
+BrinView brin_view(Brin *b);
+
+/**
+ * @brief Returns a view over `length` bytes starting at `data`.
+ *
+ * @param data   Pointer to the first byte (may be NULL only if `length` is 0).
+ * @param length Number of bytes in the span.
+ * @return A BrinView covering the span.
+ */
+BrinView brin_view_n(const char *data, size_t length);
+
+/**
+ * @brief Parses a signed 64-bit decimal integer from the start of a view.
+ *
+ * Accepts an optional `+` or `-` sign followed by decimal digits. Leading
+ * whitespace is not skipped and parsing never reads past `v.length`.
+ * The result does not depend on the current locale.
+ *
+ * @param v   The span to parse.
+ * @param out Receives the parsed value, saturated to INT64_MIN/INT64_MAX on overflow.
+ * @param end If not NULL, receives the number of bytes consumed (0 if no digits).
+ *
+ * @return 1 on success, 0 if no digits were found or the value overflows.
+ */
+int brin_parse_i64(BrinView v, int64_t *out, size_t *end);
+
+/**
+ * @brief Parses an unsigned 64-bit decimal integer from the start of a view.
+ *
+ * Accepts an optional `+` sign followed by decimal digits. Leading
+ * whitespace is not skipped and parsing never reads past `v.length`.
+ * The result does not depend on the current locale.
+ *
+ * @param v   The span to parse.
+ * @param out Receives the parsed value, saturated to UINT64_MAX on overflow.
+ * @param end If not NULL, receives the number of bytes consumed (0 if no digits).
+ *
+ * @return 1 on success, 0 if no digits were found or the value overflows.
+ */
+int brin_parse_u64(BrinView v, uint64_t *out, size_t *end);
+
+/**
+ * @brief Parses a decimal floating-point number from the start of a view.
+ *
+ * Accepts `[+-]digits[.digits][(e|E)[+-]digits]` as well as `inf`,
+ * `infinity` and `nan` (case-insensitive). The decimal separator is always `.`,
+ * whatever the current locale. Leading whitespace is not skipped and parsing
+ * never reads past `v.length`.
+ *
+ * @param v   The span to parse.
+ * @param out Receives the correctly rounded value (±inf or 0 when out of range).
+ * @param end If not NULL, receives the number of bytes consumed (0 if no number).
+ *
+ * @return 1 on success, 0 if no number was found.
+ */
+int brin_parse_double(BrinView v, double *out, size_t *end);
+
+/**
+ * @brief Compare two Brin strings for equality.
+ *
+ * Compares the lengths first, then the cached hashes (computing and caching
+ * them if needed), and only runs a byte comparison when both match.
+ * Repeatedly comparing the same Brin against many candidates therefore
+ * hashes it once and rejects most candidates in constant time.
+ *
+ * @param[in,out] a Pointer to the first Brin instance.
+ * @param[in,out] b Pointer to the second Brin instance.
+ *
+ * @return 1 if both strings hold the same bytes, 0 otherwise.
+ *
+ * @pre Neither `a`, `b`, nor their strings can be NULL.
+ * @note The function terminates the program if any input pointer is NULL.
+ */
+int brin_equals_brin(Brin *a, Brin *b);
+
+/**
+ * @brief Returns the 64-bit hash of a Brin's content, caching it in `b->hash`.
+ *
+ * The hash is wyhash, a fast well-distributed non-cryptographic hash, with
+ * seed 0. It equals `brin_hash64_seeded(brin_view(b), 0)`, so views and
+ * Brins with the same bytes hash identically.
+ *
+ * @param[in,out] b Pointer to the Brin instance.
+ * @return The hash of the content.
+ *
+ * @note The function terminates the program if inputs are invalid.
+ */
+uint64_t brin_hash64(Brin *b);
+
+/**
+ * @brief Returns the seeded 64-bit hash of a span of bytes.
+ *
+ * Different seeds give independent hash functions, e.g. to harden tables
+ * against crafted keys. The result is never cached.
+ *
+ * @param v    The span to hash.
+ * @param seed The seed.
+ * @return The hash of the span.
+ */
+uint64_t brin_hash64_seeded(BrinView v, uint64_t seed);
+
+/**
+ * @brief Returns the seeded 64-bit hash of a span, ignoring ASCII case.
+ *
+ * ASCII letters are folded to lowercase as they are loaded, eight bytes at
+ * a time, so no lowercased copy is made. Spans differing only in ASCII case
+ * hash identically; other bytes are hashed as-is.
+ *
+ * @param v    The span to hash.
+ * @param seed The seed.
+ * @return The case-insensitive hash of the span.
+ */
+uint64_t brin_hash64_ci(BrinView v, uint64_t seed);
+
+/**
+ * @brief Creates an empty intern table.
+ *
+ * @return An intern table holding no strings.
+ *
+ * @note The function exits the program if memory allocation fails.
+ */
+BrinInternTable brin_intern_table_new(void);
+
+/**
+ * @brief Frees an intern table and every canonical Brin it holds.
+ *
+ * All handles returned by brin_intern() on this table become invalid.
+ *
+ * @param t Pointer to the intern table to destroy.
+ */
+void brin_intern_table_destroy(BrinInternTable *t);
+
+/**
+ * @brief Returns the canonical Brin holding the bytes of `v`.
+ *
+ * The first time some bytes are seen, a canonical immutable Brin is created
+ * with its struct and bytes in one allocation; later calls with equal bytes
+ * return the same pointer without allocating. Two handles from the same
+ * table are therefore equal exactly when the pointers are equal.
+ *
+ * @param t Pointer to the intern table.
+ * @param v The bytes to intern; they are copied only on first insertion.
+ * @return The canonical Brin, owned by the table until it is destroyed.
+ *
+ * @note The returned Brin must not be modified nor destroyed.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+const Brin *brin_intern(BrinInternTable *t, BrinView v);
+
+/**
+ * @brief Creates an empty BrinMap.
+ *
+ * @return A map holding no entries.
+ *
+ * @note The function exits the program if memory allocation fails.
+ */
+BrinMap brin_map_new(void);
+
+/**
+ * @brief Frees a BrinMap and its copies of the keys.
+ *
+ * Values are not freed; they belong to the caller.
+ *
+ * @param m Pointer to the map to destroy.
+ */
+void brin_map_destroy(BrinMap *m);
+
+/**
+ * @brief Associates `value` with `key`, replacing any previous value.
+ *
+ * The key bytes are copied when a new entry is created.
+ *
+ * @param m     Pointer to the map.
+ * @param key   The key bytes.
+ * @param value The value to store (may be NULL).
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+void brin_map_put(BrinMap *m, BrinView key, void *value);
+
+/**
+ * @brief Associates `value` with the content of a Brin key.
+ *
+ * Same as brin_map_put(), but reuses the hash cached in `key`.
+ *
+ * @param m     Pointer to the map.
+ * @param key   Pointer to the Brin key; its hash gets cached.
+ * @param value The value to store (may be NULL).
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+void brin_map_put_brin(BrinMap *m, Brin *key, void *value);
+
+/**
+ * @brief Looks up the value associated with `key`, without allocating.
+ *
+ * @param m   Pointer to the map.
+ * @param key The key bytes.
+ * @return A pointer to the stored value, valid until the next insertion or
+ *         removal, or NULL if `key` is absent.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+void **brin_map_get(BrinMap *m, BrinView key);
+
+/**
+ * @brief Looks up the value associated with the content of a Brin key.
+ *
+ * Same as brin_map_get(), but reuses the hash cached in `key`.
+ *
+ * @param m   Pointer to the map.
+ * @param key Pointer to the Brin key; its hash gets cached.
+ * @return A pointer to the stored value, or NULL if `key` is absent.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+void **brin_map_get_brin(BrinMap *m, Brin *key);
+
+/**
+ * @brief Removes the entry associated with `key`, if any.
+ *
+ * @param m   Pointer to the map.
+ * @param key The key bytes.
+ * @return 1 if an entry was removed, 0 if `key` was absent.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+int brin_map_remove(BrinMap *m, BrinView key);
+
+/**
+ * @brief Iterates over the entries of a map, in unspecified order.
+ *
+ * Start with `*cursor` set to 0 and call repeatedly until it returns 0.
+ * The map must not be modified during the iteration.
+ *
+ * @param m      Pointer to the map.
+ * @param cursor Pointer to the iteration state.
+ * @param key    If not NULL, receives a view of the entry's key.
+ * @param value  If not NULL, receives the entry's value.
+ * @return 1 if an entry was produced, 0 when the iteration is over.
+ */
+int brin_map_next(const BrinMap *m, size_t *cursor, BrinView *key,
+                  void **value);
+
+/**
+ * @brief Returns a new Brin sharing the buffer of `b` instead of copying it.
+ *
+ * Both Brins reference the same bytes through a reference count. Reading
+ * functions work on the shared bytes directly; the first mutating function
+ * called on either Brin gives it a private copy, leaving the other intact.
+ * Each share must be released with brin_destroy(); the buffer is freed
+ * with the last one.
+ *
+ * The reference count is atomic, so shares may be handed to other threads
+ * and used or destroyed there, as long as each Brin struct itself is only
+ * used by one thread at a time. Build with BRIN_NO_ATOMICS for
+ * single-threaded programs.
+ *
+ * @param b Pointer to the Brin to share.
+ * @return A Brin with the same content, sharing its buffer.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+Brin brin_share(Brin *b);
+
+/**
+ * @brief Checks if the buffer of a Brin is shared with other Brins.
+ *
+ * @param b Pointer to the Brin instance.
+ * @return 1 if a mutation would copy the buffer first, 0 otherwise.
+ *
+ * @note The function terminates the program if inputs are invalid.
+ */
+int brin_is_shared(Brin *b);
+
+/**
+ * @brief Returns a Brin viewing `length` bytes of `b` from `start`, without copying.
+ *
+ * The substring shares the reference-counted buffer of `b` (see
+ * brin_share()), so the parent's bytes stay alive until both are destroyed.
+ * Its `string` points inside the parent buffer and is generally not
+ * null-terminated: use brin_cstr() when a C string is needed. The first
+ * mutation, or the first call needing a terminator, gives it a private
+ * copy of just its own bytes.
+ *
+ * @param b      Pointer to the parent Brin.
+ * @param start  Index of the first byte of the substring.
+ * @param length Number of bytes in the substring.
+ * @return A Brin sharing the parent's buffer.
+ *
+ * @note The function exits the program if inputs are invalid, if the range
+ *       is out of bounds, or if memory allocation fails.
+ */
+Brin brin_substr_shared(Brin *b, size_t start, size_t length);
+
+/**
+ * @brief Returns the content of a Brin as a null-terminated C string.
+ *
+ * For shared substrings that do not end where their parent does, this
+ * first gives the Brin a private null-terminated copy of its bytes.
+ * Every other Brin is returned as is.
+ *
+ * @param b Pointer to the Brin instance.
+ * @return `b->string`, guaranteed to be null-terminated.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+const char *brin_cstr(Brin *b);
+
+/**
+ * @brief Appends a view to a Brin lazily, without copying its bytes.
+ *
+ * The view is recorded as a pending piece in O(1); the bytes are copied
+ * only when the Brin is flattened, which happens in brin_cstr() and in any
+ * other function that reads or modifies the content. brin_write() outputs
+ * pending pieces without flattening. `b->length` already includes the
+ * pending pieces, but `b->string` only holds the flattened prefix.
+ *
+ * @param[in,out] b Pointer to the Brin instance.
+ * @param[in] piece Bytes to append; they must stay valid and unchanged
+ *                  until the Brin is flattened or destroyed. A view of
+ *                  `b`'s own content is allowed.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+void brin_concat_lazy(Brin *b, BrinView piece);
+
+/**
+ * @brief Appends a Brin to another lazily, taking ownership of its buffer.
+ *
+ * Works like brin_concat_lazy(), but the buffer of `piece` is moved into
+ * `b` instead of being borrowed, so the bytes live as long as needed.
+ * Pending pieces of `piece` are moved along. `piece` is left empty, as if
+ * destroyed.
+ *
+ * @param[in,out] b     Pointer to the Brin instance to append to.
+ * @param[in,out] piece Pointer to the Brin to move; must not be `b`.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+void brin_concat_lazy_brin(Brin *b, Brin *piece);
+
+/**
+ * @brief Writes the content of a Brin to a file descriptor.
+ *
+ * Pending pieces from brin_concat_lazy() are streamed straight from where
+ * they live with `writev`, without flattening the Brin. Partial writes and
+ * interrupted calls are retried until everything is written.
+ *
+ * @param fd Open file descriptor to write to.
+ * @param b  Pointer to the Brin instance.
+ * @return The number of bytes written (`b->length`), or -1 on error with `errno` set.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+ssize_t brin_write(int fd, Brin *b);
+
+/**
+ * @brief Writes views to a file descriptor, with a separator between them, without joining them.
+ *
+ * The bytes go out exactly as brin_join_n() would lay them out, but no
+ * joined buffer is built: the views and separators are gathered into
+ * batches of `iovec` entries and written with `writev`, resuming after
+ * partial writes and signal interruptions.
+ *
+ * @param fd      File descriptor to write to.
+ * @param pieces  Array of `count` views, e.g. from brin_view() or brin_column_get().
+ * @param count   Number of views.
+ * @param sep     Separator written between views (may be NULL only if `sep_len` is 0).
+ * @param sep_len Length of the separator.
+ * @return The number of bytes written, or -1 on error (with `errno` set).
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+ssize_t brin_writev(int fd, const BrinView *pieces, size_t count,
+                    const char *sep, size_t sep_len);
+
+/**
+ * @brief Creates a Brin taking ownership of a malloc'd buffer, without copying it.
+ *
+ * The buffer becomes the Brin's storage: it is freed by brin_destroy() and
+ * its spare room is used by later appends. When `capacity` leaves no room
+ * for the terminator, the buffer is grown by one byte with `realloc`.
+ *
+ * @param ptr      Buffer allocated with malloc, calloc or realloc.
+ * @param length   Number of content bytes at the start of the buffer.
+ * @param capacity Size of the buffer in bytes (at least `length`).
+ * @return A Brin owning the buffer.
+ *
+ * @note The caller must not use or free `ptr` afterwards.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+Brin brin_adopt(char *ptr, size_t length, size_t capacity);
+
+/**
+ * @brief Hands the buffer of a Brin back to the caller, without copying it.
+ *
+ * The returned buffer is null-terminated and must be released with free().
+ * The Brin is left empty, as if destroyed. A buffer still shared with other
+ * Brins, or pending lazy pieces, are copied into a fresh buffer first.
+ *
+ * @param b      Pointer to the Brin instance.
+ * @param length If not NULL, receives the number of content bytes.
+ * @return The malloc'd buffer holding the content.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+char *brin_release(Brin *b, size_t *length);
+
+/**
+ * @brief Creates an independent copy of a Brin.
+ *
+ * The content is copied with a single exact-size allocation using the
+ * known length, so embedded null bytes are kept and nothing is re-measured.
+ * The cached hash, if any, carries over to the copy.
+ *
+ * @param b Pointer to the Brin instance to copy.
+ * @return A new Brin owning its own copy of the content.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+Brin brin_clone(Brin *b);
+
+/**
+ * @brief Transfers the content of `src` to `dst` without copying it.
+ *
+ * Whatever `dst` held is destroyed first; `src` is left empty, as if
+ * destroyed, and may be reused or destroyed again safely.
+ *
+ * @param[out]    dst Pointer to the destination, a Brin instance or a destroyed one.
+ * @param[in,out] src Pointer to the Brin instance to move from.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+void brin_move(Brin *dst, Brin *src);
+
+/**
+ * @brief Exchanges the contents of two Brin instances without copying them.
+ *
+ * @param[in,out] a Pointer to the first Brin instance.
+ * @param[in,out] b Pointer to the second Brin instance.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+void brin_swap(Brin *a, Brin *b);
+
+/**
+ * @brief Creates an empty column.
+ *
+ * @return A column holding no fields.
+ *
+ * @note The function exits the program if memory allocation fails.
+ */
+BrinColumn brin_column_new(void);
+
+/**
+ * @brief Frees the byte pool and offset table of a column.
+ *
+ * @param c Pointer to the column to destroy.
+ */
+void brin_column_destroy(BrinColumn *c);
+
+/**
+ * @brief Appends a copy of the bytes of `v` as the last field of a column.
+ *
+ * @param c Pointer to the column.
+ * @param v The bytes to append.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+void brin_column_push(BrinColumn *c, BrinView v);
+
+/**
+ * @brief Returns a view over field `i` of a column.
+ *
+ * The view points into the byte pool and stays valid until the column is
+ * modified or destroyed.
+ *
+ * @param c Pointer to the column.
+ * @param i Index of the field.
+ * @return A BrinView over the field.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+BrinView brin_column_get(const BrinColumn *c, size_t i);
+
+/**
+ * @brief Splits the content of a Brin into a column.
+ *
+ * Tokens follow the same rules as brin_split(): every byte of `sep` is a
+ * delimiter, runs of delimiters are collapsed and empty tokens are skipped.
+ * Instead of one allocation per token, all tokens are copied into a single
+ * byte pool, sized exactly after a counting pass.
+ *
+ * @param b   Pointer to the Brin instance to split.
+ * @param sep The null-terminated set of delimiter bytes.
+ * @return A column holding the tokens, to be freed with brin_column_destroy().
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+BrinColumn brin_split_column(Brin *b, const char *sep);
+
+/**
+ * @brief Joins the fields of a column into a new Brin.
+ *
+ * The result is built in a single allocation of the exact final size.
+ *
+ * @param c       Pointer to the column.
+ * @param sep     Separator placed between fields (may be NULL only if `sep_len` is 0).
+ * @param sep_len Length of the separator.
+ * @return A Brin holding the joined fields.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+Brin brin_column_join(const BrinColumn *c, const char *sep, size_t sep_len);
+
+/**
+ * @brief Sorts the fields of a column in bytewise lexicographic order.
+ *
+ * The fields are sorted through a table of views, then copied once into a
+ * new byte pool so that the column stays a sequential scan in sorted order.
+ *
+ * @param c Pointer to the column.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+void brin_column_sort(BrinColumn *c);
+
+/**
+ * @brief Computes the 64-bit hash of every field of a column.
+ *
+ * With a seed of 0, `out[i]` equals brin_hash64() of a Brin holding the
+ * same bytes as field `i`, so fields can be matched against Brins through
+ * their cached hashes.
+ *
+ * @param c    Pointer to the column.
+ * @param seed Seed mixed into every hash.
+ * @param out  Array of at least `c->count` entries receiving the hashes.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+void brin_column_hashes(const BrinColumn *c, uint64_t seed, uint64_t *out);
+
+/**
+ * @brief Creates an empty CSV record set.
+ *
+ * @param delimiter Field delimiter, such as `,` or `\t`; it cannot be a
+ *                  quote, a line break or a null byte.
+ * @return A record set holding no records.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+BrinCsv brin_csv_new(char delimiter);
+
+/**
+ * @brief Frees a CSV record set.
+ *
+ * @param csv Pointer to the record set to destroy.
+ */
+void brin_csv_destroy(BrinCsv *csv);
+
+/**
+ * @brief Removes every record from a CSV record set, keeping its memory.
+ *
+ * @param csv Pointer to the record set.
+ */
+void brin_csv_clear(BrinCsv *csv);
+
+/**
+ * @brief Parses CSV text and appends its records to a record set.
+ *
+ * Fields are separated by the delimiter of `csv` and records by `\n` or
+ * `\r\n`. A field may be enclosed in double quotes, in which case it can
+ * contain delimiters, line breaks and doubled quotes (`""`) standing for
+ * one quote. A final line break is optional. A stray quote inside an
+ * unquoted field still toggles quoting, and that field is kept as it is.
+ *
+ * The input is classified 64 bytes at a time with SIMD comparisons (SSE2
+ * or AVX2, see brin_cpu_features()), and quoted regions are found with a prefix XOR over the
+ * quote bitmask, so only field boundaries are visited one by one.
+ *
+ * @param csv   Pointer to the record set receiving the records.
+ * @param input The CSV text.
+ * @return 1 on success, 0 if the input ends inside a quoted field (the
+ *         last field then holds everything after its opening quote).
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+int brin_csv_parse(BrinCsv *csv, BrinView input);
+
+/**
+ * @brief Returns the number of fields in a record.
+ *
+ * @param csv    Pointer to the record set.
+ * @param record Index of the record.
+ * @return The number of fields of the record.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+size_t brin_csv_field_count(const BrinCsv *csv, size_t record);
+
+/**
+ * @brief Returns a view over one field of a record.
+ *
+ * @param csv    Pointer to the record set.
+ * @param record Index of the record.
+ * @param field  Index of the field within the record.
+ * @return A BrinView over the unescaped field, valid until the record set
+ *         is modified or destroyed.
+ *
+ * @note The function exits the program if inputs are invalid.
+ */
+BrinView brin_csv_field(const BrinCsv *csv, size_t record, size_t field);
+
+/**
+ * @brief Parses CSV records from a file descriptor in bounded memory.
+ *
+ * Reads up to `block_size` bytes at a time into one reusable buffer and
+ * parses every complete record in it, with the same rules as
+ * brin_csv_parse(). The records of each block are handed to `on_records`
+ * as a record set that is cleared afterwards; a record spanning a block
+ * boundary is kept in the buffer and delivered once its end has been read.
+ * Memory use stays proportional to the block size plus the longest record,
+ * whatever the size of the input, and each byte is scanned once however
+ * short the reads are.
+ *
+ * @param fd         File descriptor to read until end of file.
+ * @param delimiter  Field delimiter, as for brin_csv_new().
+ * @param block_size Number of bytes to read at a time, or 0 for 64 KiB.
+ * @param on_records Called with each batch of records; returns non-zero to
+ *                   go on reading, 0 to stop early.
+ * @param ctx        Passed unchanged to `on_records`.
+ * @return 1 once the input is parsed or `on_records` stops the stream, 0 if
+ *         the input ends inside a quoted field (its last record is still
+ *         delivered), -1 on a read error (with `errno` set).
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+int brin_csv_stream(int fd, char delimiter, size_t block_size,
+                    int (*on_records)(const BrinCsv *csv, void *ctx),
+                    void *ctx);
+
+/**
+ * @brief Reads the next line of a stream into a Brin, reusing its buffer.
+ *
+ * The line replaces the content of `b`, without its trailing `\n`. The
+ * existing allocation of `b` is handed to `getline`, so reading many lines
+ * into the same Brin allocates only when a line is longer than any before.
+ * Null bytes inside the line are kept.
+ *
+ * @param b      Pointer to the Brin instance receiving the line.
+ * @param stream The stream to read from.
+ * @return The number of bytes consumed from the stream, newline included,
+ *         0 at end of file, or -1 on a read error (`b` is then empty).
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+ssize_t brin_read_line(Brin *b, FILE *stream);
+
+/**
+ * @brief Creates a block-buffered reader over a file descriptor.
+ *
+ * @param fd         File descriptor to read from; it is not closed by the reader.
+ * @param block_size Number of bytes to read at a time, or 0 for 64 KiB.
+ * @return A reader with an empty buffer.
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+BrinReader brin_reader_new(int fd, size_t block_size);
+
+/**
+ * @brief Frees the buffer of a reader, leaving its file descriptor open.
+ *
+ * @param r Pointer to the reader to destroy.
+ */
+void brin_reader_destroy(BrinReader *r);
+
+/**
+ * @brief Reads the next line of a file descriptor into a Brin, reusing its buffer.
+ *
+ * Same as brin_read_line(), for a file descriptor: the reader fetches
+ * whole blocks with `read`, the newline is searched with `memchr` over the
+ * buffered bytes, and the line is copied into the existing allocation of
+ * `b`, which grows only when a line is longer than any before.
+ *
+ * @param b Pointer to the Brin instance receiving the line.
+ * @param r Pointer to the reader.
+ * @return The number of bytes consumed, newline included, 0 at end of file,
+ *         or -1 on a read error (with `errno` set; `b` then holds the bytes
+ *         of the line read so far).
+ *
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+ssize_t brin_read_line_fd(Brin *b, BrinReader *r);
+
+/** @brief brin_map_file() hint: the file will be read from start to end. */
+#define BRIN_MMAP_SEQUENTIAL 1
+/** @brief brin_map_file() hint: the file will be read in random order. */
+#define BRIN_MMAP_RANDOM 2
+/** @brief brin_map_file() hint: the whole file will be needed soon. */
+#define BRIN_MMAP_WILLNEED 4
+/** @brief brin_new_mapped() hint: back the buffer with transparent huge pages. */
+#define BRIN_MMAP_HUGEPAGES 8
+
+/**
+ * @brief Maps a file into memory as a read-only Brin, without copying it.
+ *
+ * The Brin reads the file pages directly and works with every function
+ * that does not modify it, such as searching, hashing, splitting, views
+ * and brin_write(). The first modification, or a call to brin_cstr() when
+ * the file does not end with a null byte, copies the content to the heap.
+ * The mapping is released by brin_destroy(), once every share or
+ * substring of it has been destroyed too.
+ *
+ * @param path  Path of the file to map.
+ * @param b     Receives the Brin on success; left untouched on failure.
+ * @param flags Access hints: any of BRIN_MMAP_SEQUENTIAL, BRIN_MMAP_RANDOM
+ *              and BRIN_MMAP_WILLNEED, or 0.
+ * @return 0 on success, -1 if the file cannot be opened, read or mapped
+ *         (with `errno` set).
+ *
+ * @note Changes made to the file while it is mapped show through the Brin.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+int brin_map_file(const char *path, Brin *b, int flags);
+
+/**
+ * @brief Creates an empty Brin stored in an anonymous memory mapping.
+ *
+ * Meant for very large outputs built by appending: brin_concat(),
+ * brin_concat_n() and flattening lazy pieces write into the mapping and
+ * grow it with `mremap`, which moves page table entries instead of copying
+ * the bytes as `realloc` may do. Any other modification, a share that gets
+ * modified, or brin_release() moves the content back to the heap first.
+ *
+ * @param capacity Initial size in bytes, rounded up to whole pages.
+ * @param flags    BRIN_MMAP_HUGEPAGES to ask for transparent huge pages, or 0.
+ * @return An empty Brin backed by the mapping.
+ *
+ * @note Without `mremap` (outside Linux), growing maps a larger region and copies into it.
+ * @note The function exits the program if memory allocation fails.
+ */
+Brin brin_new_mapped(size_t capacity, int flags);
+
+/**
+ * @brief Reads many files concurrently into pre-sized Brins.
+ *
+ * Each file is opened and measured, then read straight into a Brin
+ * allocated at its exact size. On Linux the reads are batched through
+ * io_uring; where it is unavailable (older kernels, sandboxes, or builds
+ * with BRIN_NO_IO_URING), the files are read with `pread` on a small pool
+ * of threads instead.
+ *
+ * @param paths  Array of `count` file paths.
+ * @param count  Number of files.
+ * @param out    Array of `count` Brins receiving the contents, to be
+ *               destroyed by the caller; a file that cannot be read gets
+ *               an empty Brin.
+ * @param errors If not NULL, receives an `errno` value per file, 0 when it
+ *               was read.
+ * @return The number of files read successfully.
+ *
+ * @note Files are read up to the size they had when opened.
+ * @note The function exits the program if inputs are invalid or memory allocation fails.
+ */
+size_t brin_load_files(const char *const *paths, size_t count, Brin *out,
+                       int *errors);
+
+/** @brief brin_cpu_features() bit: SSE2 kernels are in use. */
+#define BRIN_CPU_SSE2 1u
+/** @brief brin_cpu_features() bit: SSE4.2 kernels are in use. */
+#define BRIN_CPU_SSE42 2u
+/** @brief brin_cpu_features() bit: AVX2 kernels are in use. */
+#define BRIN_CPU_AVX2 4u
+
+/**
+ * @brief Returns the CPU features used by the SIMD kernels of the library.
+ *
+ * Searching, case conversion, trimming, splitting and CSV parsing each have
+ * scalar, SSE2 and, on x86, SSE4.2 or AVX2 kernels. The best one for the
+ * running CPU is picked once, when the library is loaded, so a single
+ * binary runs at full speed across CPU generations. Setting the environment
+ * variable `BRIN_CPU` to `scalar`, `sse2`, `sse4.2` or `avx2` before the
+ * program starts caps the level, e.g. to compare kernels in benchmarks.
+ *
+ * @return A combination of BRIN_CPU_SSE2, BRIN_CPU_SSE42 and BRIN_CPU_AVX2
+ *         naming the kernels in use, 0 for the scalar ones.
+ */
+unsigned brin_cpu_features(void);
+
 #endif // BRIN_H
\ No newline at end of file
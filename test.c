@@ -1,9 +1,19 @@
 // #define BRIN_LITE
+#define _POSIX_C_SOURCE 200809L
 
 #include <brin.h>
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+static int count_csv_rows(const BrinCsv *csv, void *ctx)
+{
+    size_t *counts = ctx;
+    counts[0] += csv->records;
+    counts[1]++;
+    return 1;
+}
 
 int main(void)
 {
@@ -162,5 +172,314 @@ int main(void)
 
     brin_destroy(&msg);
 #endif
+
+    Brin fields = brin_new("-42,18446744073709551615,3.25e2");
+    BrinView field = brin_view(&fields);
+    int64_t i64;
+    uint64_t u64;
+    double dbl;
+    size_t used;
+
+    brin_parse_i64(field, &i64, &used);
+    printf("parse i64: %lld (%zu bytes)\n", (long long)i64, used);
+    field = brin_view_n(field.data + used + 1, field.length - used - 1);
+    brin_parse_u64(field, &u64, &used);
+    printf("parse u64: %llu (%zu bytes)\n", (unsigned long long)u64, used);
+    field = brin_view_n(field.data + used + 1, field.length - used - 1);
+    brin_parse_double(field, &dbl, &used);
+    printf("parse double: %g (%zu bytes)\n", dbl, used);
+    brin_destroy(&fields);
+
+    Brin key = brin_new("status=200");
+    Brin same = brin_new("status=200");
+    Brin other = brin_new("status=404");
+    printf("equals_brin: %d %d\n", brin_equals_brin(&key, &same),
+           brin_equals_brin(&key, &other));
+    brin_concat(&other, "!");
+    printf("equals_brin after concat: %d\n", brin_equals_brin(&key, &other));
+    printf("hash64 matches view: %d\n",
+           brin_hash64(&key) == brin_hash64_seeded(brin_view(&key), 0));
+    printf("hash64_ci ignores case: %d\n",
+           brin_hash64_ci(brin_view_n("Content-Type", 12), 7) ==
+           brin_hash64_ci(brin_view_n("content-type", 12), 7));
+    brin_destroy(&key);
+    brin_destroy(&same);
+    brin_destroy(&other);
+
+    BrinInternTable hosts = brin_intern_table_new();
+    Brin line = brin_new("GET example.org example.org");
+    const Brin *first = brin_intern(&hosts, brin_view_n(line.string + 4, 11));
+    const Brin *second = brin_intern(&hosts, brin_view_n(line.string + 16, 11));
+    printf("interned %s, same handle: %d, count: %zu\n", first->string,
+           first == second, hosts.count);
+    brin_destroy(&line);
+    brin_intern_table_destroy(&hosts);
+
+    BrinMap counts = brin_map_new();
+    const char *codes[] = {"200", "404", "200", "500", "200"};
+    int seen[5] = {0};
+    for (size_t i = 0; i < sizeof(codes) / sizeof(codes[0]); i++)
+    {
+        void **slot = brin_map_get(&counts, brin_view_n(codes[i], 3));
+        if (!slot) brin_map_put(&counts, brin_view_n(codes[i], 3), &seen[i]);
+        slot = brin_map_get(&counts, brin_view_n(codes[i], 3));
+        (*(int *)*slot)++;
+    }
+    Brin ok = brin_new("200");
+    printf("map: %zu keys, 200 seen %d times\n", counts.count,
+           *(int *)*brin_map_get_brin(&counts, &ok));
+    brin_map_remove(&counts, brin_view_n("404", 3));
+    printf("map after remove: %zu keys, 404 present: %d\n", counts.count,
+           brin_map_get(&counts, brin_view_n("404", 3)) != NULL);
+    brin_destroy(&ok);
+    brin_map_destroy(&counts);
+
+    Brin payload = brin_new("shared payload");
+    Brin copy1 = brin_share(&payload);
+    Brin copy2 = brin_share(&payload);
+    printf("shared: %d, same buffer: %d\n", brin_is_shared(&copy1),
+           copy1.string == payload.string);
+    brin_to_upper(&copy2);
+    printf("after cow: %s / %s, copy2 shared: %d\n", payload.string,
+           copy2.string, brin_is_shared(&copy2));
+    brin_destroy(&payload);
+    printf("last owner shared: %d, %s\n", brin_is_shared(&copy1), copy1.string);
+    brin_destroy(&copy1);
+    brin_destroy(&copy2);
+
+    Brin header = brin_new("Host: example.org\r\nAccept: */*\r\n");
+    Brin name = brin_substr_shared(&header, 0, 4);
+    Brin value = brin_substr_shared(&header, 6, 11);
+    printf("substr shares parent: %d, name length: %zu\n",
+           value.string == header.string + 6, name.length);
+    brin_destroy(&header);
+    printf("substr after parent destroyed: %s=%s\n", brin_cstr(&name),
+           brin_cstr(&value));
+    brin_destroy(&name);
+    brin_destroy(&value);
+
+    Brin response = brin_new("lazy: ");
+    Brin status = brin_new("200 OK");
+    brin_concat_lazy(&response, brin_view_n("HTTP/1.1 ", 9));
+    brin_concat_lazy_brin(&response, &status);
+    brin_concat_lazy(&response, brin_view_n("\n", 1));
+    fflush(stdout);
+    brin_write(1, &response);
+    printf("lazy length %zu, flattened: %s", response.length,
+           brin_cstr(&response));
+    brin_destroy(&response);
+
+    Brin echo = brin_new("echo ");
+    brin_concat_lazy(&echo, brin_view(&echo));
+    brin_concat_lazy(&echo, brin_view_n(echo.string, 4));
+    printf("lazy self-append: %s\n", brin_cstr(&echo));
+    Brin tail_a = brin_new("x");
+    Brin tail_b = brin_share(&tail_a);
+    brin_concat_lazy(&tail_a, brin_view_n("a", 1));
+    brin_concat_lazy(&tail_b, brin_view_n("b", 1));
+    printf("shared buffers, different lazy tails equal: %d\n",
+           brin_equals_brin(&tail_a, &tail_b));
+    Brin probe = brin_new("needle in a haystack");
+    brin_concat_lazy(&probe, brin_view_n(", another needle", 16));
+    int probe_found = brin_contains_n(&probe, probe.string, 6);
+    brin_concat_lazy(&probe, brin_view_n("!", 1));
+    int probe_index = brin_index_of_n(&probe, probe.string + 12, 3);
+    brin_concat_lazy(&probe, brin_view_n("?", 1));
+    brin_replace_n(&probe, probe.string, 6, probe.string + 12, 8);
+    printf("lazy needles from the prefix: %d %d, replaced: %s\n", probe_found,
+           probe_index, probe.string);
+    brin_destroy(&probe);
+    Brin hello = brin_new("hello");
+    brin_concat_lazy(&hello, brin_view_n(" world", 6));
+    brin_concat_n(&hello, hello.string, 5);
+    brin_concat_lazy(&hello, brin_view_n("!", 1));
+    brin_insert_n(&hello, 0, hello.string + 6, 5);
+    printf("lazy self-concat and insert: %s\n", hello.string);
+    brin_destroy(&hello);
+    brin_destroy(&echo);
+    brin_destroy(&tail_a);
+    brin_destroy(&tail_b);
+
+    Brin frame = brin_new_n("key\0value", 9);
+    brin_concat_n(&frame, "\0end", 4);
+    printf("binary: length %zu, index of \"\\0value\": %d, contains \"\\0end\": %d\n",
+           frame.length, brin_index_of_n(&frame, "\0value", 6),
+           brin_contains_n(&frame, "\0end", 4));
+    brin_replace_n(&frame, "\0", 1, "=", 1);
+    printf("binary replaced: %s, equals: %d\n", frame.string,
+           brin_equals_n(&frame, "key=value=end", 13));
+    brin_destroy(&frame);
+
+    Brin packet = brin_new_n("  \0a,b\0c  ", 11);
+    brin_trim(&packet);
+    char **tokens = brin_split(&packet, ",");
+    size_t token_count = 0;
+    for (size_t i = 0; tokens[i] != NULL; i++, token_count++) free(tokens[i]);
+    free(tokens);
+    printf("binary trim keeps %zu bytes, split into %zu tokens\n",
+           packet.length, token_count);
+    brin_destroy(&packet);
+
+    char *buffer = malloc(32);
+    memcpy(buffer, "adopted", 7);
+    Brin adopted = brin_adopt(buffer, 7, 32);
+    brin_concat(&adopted, " in place");
+    size_t released_length;
+    char *released = brin_release(&adopted, &released_length);
+    printf("adopt/release: %s (%zu bytes, same buffer: %d, emptied: %d)\n",
+           released, released_length, released == buffer,
+           adopted.string == NULL);
+    free(released);
+
+    Brin original = brin_new("original");
+    Brin slot = brin_clone(&original);
+    Brin moved = brin_new("placeholder");
+    brin_move(&moved, &slot);
+    brin_concat(&moved, " (moved clone)");
+    brin_swap(&original, &moved);
+    printf("clone/move/swap: %s | %s | source emptied: %d\n",
+           original.string, moved.string, slot.string == NULL);
+    brin_destroy(&original);
+    brin_destroy(&moved);
+    brin_destroy(&slot);
+
+    Brin sentence = brin_new("pear apple  fig banana");
+    BrinColumn words = brin_split_column(&sentence, " ");
+    brin_column_sort(&words);
+    Brin sorted = brin_column_join(&words, ",", 1);
+    uint64_t word_hashes[4];
+    brin_column_hashes(&words, 0, word_hashes);
+    Brin fig = brin_new("fig");
+    BrinView second_word = brin_column_get(&words, 1);
+    printf("column: %zu fields, sorted: %s, second: %.*s, hash matches: %d\n",
+           words.count, sorted.string, (int)second_word.length, second_word.data,
+           word_hashes[2] == brin_hash64(&fig));
+    brin_destroy(&fig);
+    brin_destroy(&sorted);
+    brin_column_destroy(&words);
+    brin_destroy(&sentence);
+
+    Brin path = brin_new("/usr/local//bin/");
+    char **segments = brin_split_packed(&path, "/");
+    printf("packed split:");
+    for (size_t i = 0; segments[i] != NULL; i++) printf(" [%s]", segments[i]);
+    printf("\n");
+    brin_split_free(segments);
+    brin_destroy(&path);
+
+    Brin header_line = brin_new("Host: example.com:8080");
+    char **key_value = brin_split_n(&header_line, ": ", 2);
+    printf("split_n: [%s] [%s]\n", key_value[0], key_value[1]);
+    for (size_t i = 0; key_value[i] != NULL; i++) free(key_value[i]);
+    free(key_value);
+    brin_destroy(&header_line);
+
+    Brin table = brin_new("name,quote\r\n"
+                          "Ada,\"Count, \"\"not\"\" \nnumbers\"\r\n"
+                          "Alan,\"\"\n");
+    BrinCsv csv = brin_csv_new(',');
+    int csv_ok = brin_csv_parse(&csv, brin_view(&table));
+    BrinView quote = brin_csv_field(&csv, 1, 1);
+    printf("csv: ok %d, %zu records, %zu fields in record 1, quote: [%.*s]\n",
+           csv_ok, csv.records, brin_csv_field_count(&csv, 1),
+           (int)quote.length, quote.data);
+    brin_csv_destroy(&csv);
+    brin_destroy(&table);
+
+    FILE *csv_file = tmpfile();
+    for (int i = 0; i < 100; i++)
+        fprintf(csv_file, "%d,\"row %d, with a comma\"\n", i, i);
+    rewind(csv_file);
+    size_t csv_counts[2] = {0, 0};
+    int stream_status = brin_csv_stream(fileno(csv_file), ',', 256,
+                                        count_csv_rows, csv_counts);
+    printf("csv stream: status %d, %zu records in %zu batches\n",
+           stream_status, csv_counts[0], csv_counts[1]);
+    fclose(csv_file);
+
+    FILE *log_file = tmpfile();
+    fputs("first line\nsecond, longer line\nlast line without newline", log_file);
+    rewind(log_file);
+    Brin log_line = brin_new("");
+    size_t line_count = 0, longest = 0;
+    while (brin_read_line(&log_line, log_file) > 0)
+    {
+        line_count++;
+        if (log_line.length > longest) longest = log_line.length;
+    }
+    rewind(log_file);
+    BrinReader reader = brin_reader_new(fileno(log_file), 8);
+    size_t fd_line_count = 0;
+    while (brin_read_line_fd(&log_line, &reader) > 0) fd_line_count++;
+    printf("read_line: %zu lines (longest %zu), fd reader: %zu lines\n",
+           line_count, longest, fd_line_count);
+    brin_reader_destroy(&reader);
+    brin_destroy(&log_line);
+    fclose(log_file);
+
+    Brin source;
+    if (brin_map_file("test.c", &source, BRIN_MMAP_SEQUENTIAL) == 0)
+    {
+        char **source_lines = brin_split_n(&source, "\n", 2);
+        printf("mapped test.c: first line: %s, mentions brin_map_file: %d\n",
+               source_lines[0], brin_contains_n(&source, "brin_map_file", 13));
+        for (size_t i = 0; source_lines[i] != NULL; i++) free(source_lines[i]);
+        free(source_lines);
+        brin_destroy(&source);
+    }
+
+    Brin big = brin_new_mapped(0, BRIN_MMAP_HUGEPAGES);
+    for (int i = 0; i < 100000; i++) brin_concat_n(&big, "0123456789", 10);
+    printf("mapped output: %zu bytes, capacity %zu, ends with %s\n",
+           big.length, big.capacity, big.string + big.length - 4);
+    brin_destroy(&big);
+
+    Brin city = brin_new("Paris");
+    BrinView out_fields[] = { brin_view_n("writev", 6), brin_view(&city),
+                              brin_view_n("no join buffer\n", 15) };
+    fflush(stdout);
+    brin_writev(1, out_fields, 3, ": ", 2);
+    brin_destroy(&city);
+
+    const char *load_paths[] = {"brin.h", "test.c", "missing.txt"};
+    Brin loaded[3];
+    int load_errors[3];
+    size_t loaded_count = brin_load_files(load_paths, 3, loaded, load_errors);
+    printf("load_files: %zu of 3 loaded, test.c mentions it: %d, missing.txt error set: %d\n",
+           loaded_count, brin_contains_n(&loaded[1], "brin_load_files", 15),
+           load_errors[2] != 0);
+    for (size_t i = 0; i < 3; i++) brin_destroy(&loaded[i]);
+
+    unsigned cpu = brin_cpu_features();
+    Brin shout = brin_new("   simd kernels pick sse2, sse4.2 or avx2 at run time   ");
+    brin_trim(&shout);
+    brin_to_upper(&shout);
+    printf("cpu features:%s%s%s -> %s\n",
+           cpu & BRIN_CPU_SSE2 ? " sse2" : "", cpu & BRIN_CPU_SSE42 ? " sse4.2" : "",
+           cpu & BRIN_CPU_AVX2 ? " avx2" : "", shout.string);
+    brin_destroy(&shout);
+
+    Brin blob = brin_new_n("", 0);
+    for (int i = 0; i < 8; i++) brin_concat_n(&blob, "bin\0ary data\0", 13);
+    char **whole = brin_split(&blob, "");
+    char **capped = brin_split_n(&blob, "", 3);
+    char **packed = brin_split_packed(&blob, "");
+    BrinColumn blob_column = brin_split_column(&blob, "");
+    char **at_nul = brin_split(&blob, " ");
+    size_t nul_tokens = 0;
+    while (at_nul[nul_tokens]) nul_tokens++;
+    printf("binary split, empty separator: %s/%s/%s, column %zu field of %zu bytes, "
+           "on spaces: %zu tokens\n", whole[0], capped[0], packed[0],
+           blob_column.count, brin_column_get(&blob_column, 0).length, nul_tokens);
+    for (size_t i = 0; whole[i]; i++) free(whole[i]);
+    free(whole);
+    for (size_t i = 0; capped[i]; i++) free(capped[i]);
+    free(capped);
+    for (size_t i = 0; at_nul[i]; i++) free(at_nul[i]);
+    free(at_nul);
+    brin_split_free(packed);
+    brin_column_destroy(&blob_column);
+    brin_destroy(&blob);
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include <brin.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WORKERS 8
+#define ROUNDS 20000
+
+static const char *payload_text = "payload shared across producer and consumer threads";
+
+/* One-slot mailbox through which each worker hands shares to the next one. */
+typedef struct Mailbox
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    Brin item;
+    int full;
+} Mailbox;
+
+typedef struct Worker
+{
+    pthread_t thread;
+    Brin own;
+    Mailbox *inbox;
+    Mailbox *outbox;
+    int failures;
+} Worker;
+
+static void mailbox_put(Mailbox *m, Brin b)
+{
+    pthread_mutex_lock(&m->lock);
+    while (m->full) pthread_cond_wait(&m->changed, &m->lock);
+    m->item = b;
+    m->full = 1;
+    pthread_cond_broadcast(&m->changed);
+    pthread_mutex_unlock(&m->lock);
+}
+
+static Brin mailbox_take(Mailbox *m)
+{
+    pthread_mutex_lock(&m->lock);
+    while (!m->full) pthread_cond_wait(&m->changed, &m->lock);
+    Brin b = m->item;
+    m->full = 0;
+    pthread_cond_broadcast(&m->changed);
+    pthread_mutex_unlock(&m->lock);
+    return b;
+}
+
+static void *worker_run(void *arg)
+{
+    Worker *w = arg;
+    size_t len = strlen(payload_text);
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        Brin local = brin_share(&w->own);
+        if (i % 5 == 0)
+        {
+            brin_concat(&local, "!");
+            if (local.length != len + 1 || brin_is_shared(&local))
+                w->failures++;
+        }
+        else if (local.length != len ||
+                 memcmp(local.string, payload_text, len) != 0)
+        {
+            w->failures++;
+        }
+        brin_destroy(&local);
+
+        mailbox_put(w->outbox, brin_share(&w->own));
+        Brin received = mailbox_take(w->inbox);
+        if (!brin_equals(&received, payload_text)) w->failures++;
+        if (i % 7 == 0) brin_to_upper(&received);
+        brin_destroy(&received);
+    }
+    brin_destroy(&w->own);
+    return NULL;
+}
+
+int main(void)
+{
+    Brin payload = brin_new(payload_text);
+    Mailbox boxes[WORKERS];
+    Worker workers[WORKERS];
+
+    for (int i = 0; i < WORKERS; i++)
+    {
+        pthread_mutex_init(&boxes[i].lock, NULL);
+        pthread_cond_init(&boxes[i].changed, NULL);
+        boxes[i].full = 0;
+    }
+    for (int i = 0; i < WORKERS; i++)
+    {
+        workers[i].own = brin_share(&payload);
+        workers[i].outbox = &boxes[i];
+        workers[i].inbox = &boxes[(i + WORKERS - 1) % WORKERS];
+        workers[i].failures = 0;
+    }
+    brin_destroy(&payload);
+    for (int i = 0; i < WORKERS; i++)
+        pthread_create(&workers[i].thread, NULL, worker_run, &workers[i]);
+
+    int failures = 0;
+    for (int i = 0; i < WORKERS; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        failures += workers[i].failures;
+    }
+    for (int i = 0; i < WORKERS; i++)
+    {
+        pthread_mutex_destroy(&boxes[i].lock);
+        pthread_cond_destroy(&boxes[i].changed);
+    }
+
+    printf("Thread stress test: %d workers x %d rounds, %d failures\n",
+           WORKERS, ROUNDS, failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}